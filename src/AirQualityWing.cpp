@@ -1,29 +1,75 @@
 #include "AirQualityWing.h"
 
-// Constructor
-AirQualityWing::AirQualityWing() {}
+// Survives sleep and resets, written by suspend()
+retained static AirQualityWingRetained_t aqw_retained;
+
+static_assert(sizeof(AirQualityWingRetained_t) + sizeof(history_store_t) <= AQW_RETAINED_BYTES,
+              "retained state exceeds AQW_RETAINED_BYTES");
 
-// This fires after the hpma should have finished...
-void AirQualityWing::hpmaTimerEvent()
+// Constructor
+AirQualityWing::AirQualityWing() : cycleActive(false), pending(0), expected(0), energy(millis), budgetStretched(false), budgetInterval(0), budgetHPMAOff(false), suspended(false), log(nullptr), output(nullptr)
 {
-  // Set ready flag if we time out
-  this->measurementComplete = true;
-  this->hpmaError = true;
+  for (uint8_t i = 0; i < AQW_MAX_SUBSCRIBERS; i++)
+    this->subscribers[i].events = 0;
+
+  AQW_STAT(memset(&this->perf, 0, sizeof(this->perf)));
 }
 
-// Async publish event
+// PM reading is in. Called from hpma115.process()
 void AirQualityWing::hpmaEvent()
 {
 
-  this->hpmaMeasurementComplete = true;
+  // Disable hpma
+  this->hpma115.disable();
+  this->energy.stop(ENERGY_HPMA115);
+  this->scheduler.stop(AQW_TASK_HPMA_POLL);
+  this->scheduler.stop(AQW_TASK_HPMA_TIMEOUT);
+
+  // Copy data
+  this->data.hpma115.data = this->hpma115.getData();
+  this->data.hpma115.hasData = true;
+
+  // Hourly buckets are wall clock aligned
+  if (Time.isValid())
+  {
+    this->aqi.add(Time.now(), this->data.hpma115.data.pm25, this->data.hpma115.data.pm10);
+    this->data.aqi.hasData = this->aqi.get(&this->data.aqi.data);
+  }
+
+  this->pending &= ~AQW_PENDING_HPMA115;
+  this->publish(AQW_EVENT_HPMA115);
 
   Log.trace("pm25 %dμg/m3 pm10 %dμg/m3\n", data.hpma115.data.pm25, data.hpma115.data.pm10);
 }
 
-// Measurement timer handler
-void AirQualityWing::measureTimerEvent()
+// PM reading didn't show up in time
+void AirQualityWing::hpmaTimeout()
 {
-  this->measurementStart = true;
+  Log.error("hpma timeout");
+  AQW_STAT(this->perf.timeouts++);
+
+  // Disable on error
+  this->hpma115.disable();
+  this->energy.stop(ENERGY_HPMA115);
+  this->scheduler.stop(AQW_TASK_HPMA_POLL);
+  this->scheduler.stop(AQW_TASK_HPMA_TIMEOUT);
+
+  this->abandonCycle();
+}
+
+// Temperature and humidity are in
+void AirQualityWing::shtc3Complete()
+{
+  // Set has data flag
+  this->data.shtc3.hasData = true;
+  this->energy.add(ENERGY_SHTC3, shtc3.getMeasurementTime());
+  this->publish(AQW_EVENT_SHTC3);
+
+  // Set env data in the SGP40
+  if (this->settings_.hasSGP40)
+  {
+    sgp40.setEnv(this->data.shtc3.data.raw_humidity, this->data.shtc3.data.raw_temperature);
+  }
 }
 
 AirQualityWingError_t AirQualityWing::setup(AirQualityWingHandler_t handler, AirQualityWingSettings_t settings)
@@ -37,35 +83,73 @@ AirQualityWingError_t AirQualityWing::setup(AirQualityWingHandler_t handler, Air
   // Set the settings
   this->settings_ = settings;
 
-  // Create timers
-  this->measurementTimer = new Timer(this->settings_.interval, [this](void) -> void
-                                     { return measureTimerEvent(); });
-  this->hpmaTimer = new Timer(
-      HPMA_TIMEOUT_MS, [this](void) -> void
-      { return hpmaTimerEvent(); },
-      true); // One shot enabled.
+  // Fill in per sensor defaults
+  if (this->settings_.shtc3Interval == 0)
+    this->settings_.shtc3Interval = this->settings_.interval;
+  if (this->settings_.hpma115Interval == 0)
+    this->settings_.hpma115Interval = this->settings_.interval;
+  if (this->settings_.sgp40Interval == 0)
+    this->settings_.sgp40Interval = SGP40_READ_INTERVAL;
 
   // Reset variables
-  this->measurementStart = false;
-  this->measurementComplete = false;
-  this->hpmaMeasurementComplete = false;
-  this->hpmaError = false;
+  this->scheduler.stopAll();
+  this->cycleActive = false;
+  this->pending = 0;
+  this->expected = 0;
+
+  // Keeps whatever history survived the last reset
+  this->history.begin();
+
+  // Statistics windows
+  for (uint8_t i = 0; i < AQW_CHANNEL_COUNT; i++)
+    this->stats[i].setup(this->settings_.statsWindow ? this->settings_.statsWindow : STREAM_STATS_WINDOW_MS,
+                         this->settings_.statsQuantile > 0 ? this->settings_.statsQuantile : STREAM_STATS_QUANTILE);
+
+  // Report by exception
+  for (uint8_t i = 0; i < AQW_CHANNEL_COUNT; i++)
+    this->deadband.setThreshold(i, this->settings_.deadband[i]);
+  this->deadband.setHeartbeat(this->settings_.heartbeat);
+  this->deadband.reset();
+
+  // Energy model
+  const uint32_t currents[ENERGY_COMPONENT_COUNT] = {
+      this->settings_.hpma115Current ? this->settings_.hpma115Current : ENERGY_HPMA115_UA,
+      this->settings_.sgp40Current ? this->settings_.sgp40Current : ENERGY_SGP40_UA,
+      this->settings_.shtc3Current ? this->settings_.shtc3Current : ENERGY_SHTC3_UA,
+      this->settings_.i2cCurrent ? this->settings_.i2cCurrent : ENERGY_I2C_UA,
+  };
+
+  for (uint8_t i = 0; i < ENERGY_COMPONENT_COUNT; i++)
+    this->energy.setCurrent(i, currents[i]);
+
+  this->energy.setBudget(this->settings_.energyBudget,
+                         this->settings_.energyMaxInterval ? this->settings_.energyMaxInterval : ENERGY_MAX_INTERVAL_MS);
+  this->budgetStretched = false;
+  this->budgetInterval = 0;
+  this->budgetHPMAOff = false;
+
+  this->setupAdaptive();
 
   // SGP40 setup
   if (this->settings_.hasSGP40)
   {
-    err_code = sgp40.setup();
+    err_code = sgp40.setup(&this->bus);
     if (err_code != SGP40_SUCCESS)
     {
       Log.error("sgp40 setup err %d\n", (int)err_code);
     }
+    else
+    {
+      // Sample continuously to feed the algorithm
+      this->scheduler.start(AQW_TASK_SGP40, millis(), this->settings_.sgp40Interval, this->settings_.sgp40Interval);
+    }
   }
 
   // Has the Si7021 init it
   if (this->settings_.hasSHTC3)
   {
     // Init Si7021
-    uint32_t err_code = shtc3.setup();
+    uint32_t err_code = shtc3.setup(this->settings_.shtc3LowPower, &this->bus);
     if (err_code != success)
     {
       Log.error("shtc3 setup err %d\n", (int)err_code);
@@ -95,62 +179,279 @@ AirQualityWingError_t AirQualityWing::setup(AirQualityWingHandler_t handler, Air
 AirQualityWingError_t AirQualityWing::begin()
 {
 
-  // Start the timer
-  this->measurementTimer->start();
+  uint32_t now = millis();
 
-  // Start measurement
-  this->measurementStart = true;
+  // Spread sensors without an explicit phase across the shortest period
+  // so their bus and CPU work doesn't land on the same tick
+  uint32_t shortest = 0;
+  if (this->settings_.hasSHTC3)
+    shortest = this->settings_.shtc3Interval;
+  if (this->settings_.hasHPMA115 && (shortest == 0 || this->settings_.hpma115Interval < shortest))
+    shortest = this->settings_.hpma115Interval;
+  if (this->settings_.hasSGP40 && (shortest == 0 || this->settings_.sgp40Interval < shortest))
+    shortest = this->settings_.sgp40Interval;
+
+  // No sensors at all
+  if (shortest == 0)
+    shortest = this->settings_.interval;
+
+  uint32_t sgp40Phase = this->settings_.sgp40Phase;
+  uint32_t shtc3Phase = this->settings_.shtc3Phase;
+  uint32_t hpma115Phase = this->settings_.hpma115Phase;
+
+  if (sgp40Phase == 0)
+    sgp40Phase = Scheduler::spread(0, 3, shortest);
+  if (shtc3Phase == 0)
+    shtc3Phase = Scheduler::spread(1, 3, shortest);
+  if (hpma115Phase == 0)
+    hpma115Phase = Scheduler::spread(2, 3, shortest);
+
+  if (this->settings_.hasSGP40 && this->scheduler.isActive(AQW_TASK_SGP40))
+    this->scheduler.start(AQW_TASK_SGP40, now, sgp40Phase, this->settings_.sgp40Interval);
+
+  if (this->settings_.hasSHTC3)
+    this->scheduler.start(AQW_TASK_SHTC3, now, shtc3Phase, this->sensorInterval(this->settings_.shtc3Interval));
+
+  if (this->settings_.hasHPMA115)
+    this->scheduler.start(AQW_TASK_HPMA115, now, hpma115Phase, this->sensorInterval(this->settings_.hpma115Interval));
 
   return success;
 }
 
 void AirQualityWing::end()
 {
+
+  // Everything but the SGP40 baseline sampling
+  this->scheduler.stop(AQW_TASK_SHTC3);
+  this->scheduler.stop(AQW_TASK_HPMA115);
+  this->scheduler.stop(AQW_TASK_HPMA_POLL);
+  this->scheduler.stop(AQW_TASK_HPMA_TIMEOUT);
+
+  if (this->settings_.hasHPMA115)
+  {
+    this->hpma115.disable();
+    this->energy.stop(ENERGY_HPMA115);
+  }
+
+  this->cycleActive = false;
+  this->pending = 0;
+  this->expected = 0;
 }
 
 String AirQualityWing::toString()
 {
 
-  String out = "{";
+  char buf[JSON_MAX_SIZE];
+
+  this->toJSON(buf, sizeof(buf));
+
+  return String(buf);
+}
+
+size_t AirQualityWing::toJSON(char *p_buf, size_t size, uint32_t fields)
+{
+
+  AirQualityWingData_t snapshot = this->published.read();
 
-  // If we have SGP40 data, concat
-  if (this->data.hpma115.hasData)
+  return json_write(&snapshot, fields, p_buf, size);
+}
+
+size_t AirQualityWing::toBinary(uint8_t *p_buf, size_t size)
+{
+
+  AirQualityWingData_t snapshot = this->published.read();
+
+  return record_encode(&snapshot, p_buf, size);
+}
+
+// Makes the new reading visible to readers, then tells subscribers
+void AirQualityWing::publish(uint8_t event)
+{
+  this->published.write(this->data);
+  this->updateStats(event);
+
+  if (this->settings_.adaptive)
+    this->adaptInterval(event);
+
+  for (uint8_t i = 0; i < AQW_MAX_SUBSCRIBERS; i++)
   {
-    out = String(out + String::format("\"pm25\":%d,\"pm10\":%d", this->data.hpma115.data.pm25, this->data.hpma115.data.pm10));
+    if ((this->subscribers[i].events & event) && this->subscribers[i].callback != nullptr)
+      this->subscribers[i].callback(event, this->data);
   }
+}
 
-  // If we have Si7021 data, concat
-  if (this->data.shtc3.hasData)
+// Sensor behind each AQW_CHANNEL_*
+static const uint8_t aqw_channel_event[AQW_CHANNEL_COUNT] = {
+    AQW_EVENT_HPMA115,
+    AQW_EVENT_HPMA115,
+    AQW_EVENT_SHTC3,
+    AQW_EVENT_SHTC3,
+    AQW_EVENT_SGP40,
+};
+
+// Adds the reading that triggered `event` to its channels' statistics,
+// in the units of record_schema (°C, %RH)
+void AirQualityWing::updateStats(uint8_t event)
+{
+  uint32_t now = millis();
+
+  for (uint8_t i = 0; i < AQW_CHANNEL_COUNT; i++)
   {
+    int32_t value;
 
-    // Add comma
-    if (this->data.hpma115.hasData)
-    {
-      out = String(out + ",");
-    }
+    if ((event & aqw_channel_event[i]) && aqw_channel_get(&this->data, i, &value))
+      this->stats[i].add(now, (float)value / record_schema[i].scale);
+  }
+}
 
-    out = String(out + String::format("\"temperature\":%.2f,\"humidity\":%.2f", this->data.shtc3.data.temperature, this->data.shtc3.data.humidity));
+// Stretches intervals or parks the HPMA115 if the budget says so. Once per cycle.
+void AirQualityWing::applyBudget()
+{
+  this->energy.cycle();
+
+  uint32_t requested = this->settings_.adaptive ? this->adaptive.getInterval() : this->settings_.interval;
+  energy_plan_t plan = this->energy.plan(requested);
+  bool stretched = plan.interval != requested;
+
+  // Leave intervals alone unless stretching now or undoing a stretch
+  bool changed = stretched != this->budgetStretched || (stretched && plan.interval != this->budgetInterval);
+
+  this->budgetStretched = stretched;
+  this->budgetInterval = plan.interval;
+
+  if (changed)
+  {
+    if (stretched)
+      Log.info("energy: interval %lums", (unsigned long)plan.interval);
+    else
+      Log.info("energy: interval restored");
+
+    this->updateIntervals();
   }
 
-  // If we have sgp40 data, concat
-  if (this->data.sgp40.hasData)
+  if (!this->settings_.hasHPMA115 || plan.hpma115 != this->budgetHPMAOff)
+    return;
+
+  this->budgetHPMAOff = !plan.hpma115;
+
+  if (this->budgetHPMAOff)
+  {
+    Log.warn("energy: hpma115 off");
+    this->scheduler.stop(AQW_TASK_HPMA115);
+  }
+  else
   {
+    Log.info("energy: hpma115 on");
+    uint32_t interval = this->sensorInterval(this->settings_.hpma115Interval);
+    this->scheduler.start(AQW_TASK_HPMA115, millis(), interval, interval);
+  }
+}
 
-    // Add comma
-    if (this->data.hpma115.hasData || this->data.shtc3.hasData)
-    {
-      out = String(out + ",");
-    }
+// Adaptive interval, never below the sensors' minimum. Starts over from
+// settings_.interval, so it's rerun whenever that changes.
+void AirQualityWing::setupAdaptive()
+{
+  if (!this->settings_.adaptive)
+    return;
+
+  uint32_t min = this->settings_.adaptiveMin > MIN_MEASUREMENT_DELAY_MS ? this->settings_.adaptiveMin : MIN_MEASUREMENT_DELAY_MS;
+  uint32_t max = this->settings_.adaptiveMax ? this->settings_.adaptiveMax : this->settings_.interval * ADAPTIVE_MAX_FACTOR;
+
+  this->adaptive.setup(min, max, this->settings_.interval,
+                       this->settings_.adaptiveVOCSlope ? this->settings_.adaptiveVOCSlope : ADAPTIVE_VOC_SLOPE,
+                       this->settings_.adaptivePMDelta ? this->settings_.adaptivePMDelta : ADAPTIVE_PM_DELTA);
+}
+
+// Feeds the controller and applies its decision once per cycle
+void AirQualityWing::adaptInterval(uint8_t event)
+{
+  if ((event & AQW_EVENT_SGP40) && this->data.sgp40.hasData)
+    this->adaptive.addVOC(millis(), this->data.sgp40.data.tvoc);
+
+  if ((event & AQW_EVENT_HPMA115) && this->data.hpma115.hasData)
+    this->adaptive.addPM(this->data.hpma115.data.pm25, this->data.hpma115.data.pm10);
+
+  if ((event & AQW_EVENT_CYCLE) == 0)
+    return;
+
+  adaptive_decision_t decision = this->adaptive.update();
+  if (decision == ADAPTIVE_HOLD)
+    return;
+
+  Log.info("adaptive %s: interval %lums voc slope %.1f/min pm delta %u",
+           decision == ADAPTIVE_FASTER ? "faster" : "slower", (unsigned long)this->adaptive.getInterval(),
+           this->adaptive.getVOCSlope(), this->adaptive.getPMDelta());
+
+  this->updateIntervals();
+}
+
+// The configured period scaled by the adaptive controller's factor (its
+// interval over settings_.interval), then by the budget plan's (planned
+// over requested interval). Stretches stop at the budget's max interval.
+uint32_t AirQualityWing::sensorInterval(uint32_t base)
+{
+  if (this->settings_.interval == 0)
+    return base;
+
+  uint32_t requested = this->settings_.adaptive ? this->adaptive.getInterval() : this->settings_.interval;
+  uint64_t interval = (uint64_t)base * requested / this->settings_.interval;
+
+  if (interval < MIN_MEASUREMENT_DELAY_MS)
+    interval = MIN_MEASUREMENT_DELAY_MS;
+
+  if (this->budgetStretched && this->budgetInterval > requested)
+  {
+    uint64_t stretched = interval * this->budgetInterval / requested;
+    uint32_t max = this->energy.getMaxInterval();
 
-    out = String(out + String::format("\"tvoc\":%d", this->data.sgp40.data.tvoc));
+    interval = stretched < max ? stretched : (interval > max ? interval : max);
   }
 
-  return String(out + "}");
+  return interval < UINT32_MAX ? interval : UINT32_MAX;
+}
+
+// Puts the SHTC3 and HPMA115 on their current periods
+void AirQualityWing::updateIntervals()
+{
+  if (this->settings_.hasSHTC3)
+    this->scheduler.setPeriod(AQW_TASK_SHTC3, millis(), this->sensorInterval(this->settings_.shtc3Interval));
+
+  if (this->settings_.hasHPMA115)
+    this->scheduler.setPeriod(AQW_TASK_HPMA115, millis(), this->sensorInterval(this->settings_.hpma115Interval));
+}
+
+bool AirQualityWing::getChannelStats(uint8_t channel, stream_stats_t *p_stats, bool current)
+{
+  if (channel >= AQW_CHANNEL_COUNT)
+    return false;
+
+  return this->stats[channel].get(p_stats, current);
+}
+
+void AirQualityWing::setStatsWindow(uint8_t channel, uint32_t window_ms, float quantile)
+{
+  if (channel < AQW_CHANNEL_COUNT)
+    this->stats[channel].setup(window_ms, quantile);
 }
 
 AirQualityWingData_t AirQualityWing::getData()
 {
-  return this->data;
+  return this->published.read();
+}
+
+AirQualityWingData_t AirQualityWing::getData(uint32_t *p_version)
+{
+  return this->published.read(p_version);
+}
+
+uint32_t AirQualityWing::getVersion()
+{
+  return this->published.version();
+}
+
+bool AirQualityWing::hasNewData(uint32_t version)
+{
+  return this->published.changedSince(version);
 }
 
 void AirQualityWing::attachHandler(AirQualityWingHandler_t handler)
@@ -158,167 +459,578 @@ void AirQualityWing::attachHandler(AirQualityWingHandler_t handler)
   this->handler_ = handler;
 }
 
+void AirQualityWing::attachLog(FlashLog *p_log)
+{
+  this->log = p_log;
+}
+
+void AirQualityWing::attachOutput(OutputPipeline *p_output)
+{
+  this->output = p_output;
+}
+
 void AirQualityWing::deattachHandler()
 {
   this->handler_ = nullptr;
 }
 
-AirQualityWingError_t AirQualityWing::process()
+int AirQualityWing::subscribe(uint8_t events, AirQualityWingSubscriber_t subscriber)
+{
+  for (uint8_t i = 0; i < AQW_MAX_SUBSCRIBERS; i++)
+  {
+    if (this->subscribers[i].events == 0)
+    {
+      this->subscribers[i].callback = subscriber;
+      this->subscribers[i].events = events;
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+void AirQualityWing::unsubscribe(int id)
 {
+  if (id < 0 || id >= AQW_MAX_SUBSCRIBERS)
+    return;
 
-  uint32_t err_code = success;
+  this->subscribers[id].events = 0;
+  this->subscribers[id].callback = nullptr;
+}
 
-  // Set flag if measurement is done!
-  if (this->hpmaMeasurementComplete == true)
+// Starts a cycle unless one is already running. `sensor` is the
+// AQW_PENDING_* bit of the sensor starting. The other sensors due within
+// its period belong to the same cycle, and the handler fires once all of
+// them have reported.
+void AirQualityWing::openCycle(uint8_t sensor)
+{
+  if (!this->cycleActive)
   {
-    // Reset
-    this->hpmaMeasurementComplete = false;
+    Log.trace("measurement start");
 
-    Log.trace("hpma complete");
+    uint32_t now = millis();
+    scheduler_task_t opener, other;
 
-    // Disable hpma
-    this->hpma115.disable();
+    this->cycleActive = true;
+    this->pending = 0;
+    this->expected = 0;
+    AQW_STAT(this->cycleStarted = now);
 
-    // Copy data
-    this->data.hpma115.data = this->hpma115.getData();
-    this->data.hpma115.hasData = true;
+    // Nothing from the last cycle passes for new
+    this->data.shtc3.hasData = false;
+    this->data.hpma115.hasData = false;
 
-    // Set available flag
-    this->measurementComplete = true;
+    // Already re-armed for its next run, so this is its period
+    uint32_t window = this->scheduler.getTask(sensor == AQW_PENDING_SHTC3 ? AQW_TASK_SHTC3 : AQW_TASK_HPMA115, &opener) ? opener.period : 0;
+
+    // The SHTC3 has to wake and measure inside the window too
+    uint32_t shtc3Time = (shtc3.getMeasurementTime() + 999) / 1000;
+
+    if (sensor != AQW_PENDING_SHTC3 && this->scheduler.getTask(AQW_TASK_SHTC3, &other) && (int32_t)(other.due + shtc3Time - now) < (int32_t)window)
+      this->expected |= AQW_PENDING_SHTC3;
+
+    if (sensor != AQW_PENDING_HPMA115 && this->scheduler.getTask(AQW_TASK_HPMA115, &other) && (int32_t)(other.due - now) < (int32_t)window)
+      this->expected |= AQW_PENDING_HPMA115;
   }
 
-  // If we're greater than or equal to the measurement delay
-  // start taking measurements!
-  if (this->measurementStart)
-  {
+  this->expected &= ~sensor;
+}
 
-    Log.trace("measurement start");
+// Drops the cycle without reporting it, a sensor in it failed
+void AirQualityWing::abandonCycle()
+{
+  this->cycleActive = false;
+  this->pending = 0;
+  this->expected = 0;
+}
 
-    // Set state variable to false
-    this->measurementStart = false;
+AirQualityWingError_t AirQualityWing::startSHTC3()
+{
 
-    // Reset has data variables
-    this->data.shtc3.hasData = false;
-    this->data.hpma115.hasData = false;
-    this->data.sgp40.hasData = false;
+  uint32_t err_code = success;
+
+  this->openCycle(AQW_PENDING_SHTC3);
+  this->data.shtc3.hasData = false;
 
-    // Disable HPMA
-    if (this->settings_.hasHPMA115)
-      hpma115.disable();
+  if (this->settings_.shtc3Polled)
+  {
+    // Collected by a later process() call
+    err_code = shtc3.start();
 
-    if (this->settings_.hasSHTC3)
+    if (err_code == SHTC3_SUCCESS)
+    {
+      this->pending |= AQW_PENDING_SHTC3;
+      this->kickBus();
+    }
+    else
     {
-      // Read temp and humiity
-      err_code = shtc3.read(&this->data.shtc3.data);
-
-      if (err_code == SHTC3_SUCCESS)
-      {
-        // Set has data flag
-        this->data.shtc3.hasData = true;
-
-        // Set env data in the SGP40
-        if (this->settings_.hasSGP40)
-        {
-          sgp40.setEnv(this->data.shtc3.data.raw_humidity, this->data.shtc3.data.raw_temperature);
-        }
-      }
-      else
-      {
-        Log.error("Error temp - fatal err");
-        return shtc3_error;
-      }
+      Log.error("Error temp - start err %d", (int)err_code);
+      this->abandonCycle();
+      return shtc3_error;
     }
 
-    // Process SGP40
-    if (this->settings_.hasSGP40)
+    return success;
+  }
+
+  // Read temp and humiity
+  err_code = shtc3.read(&this->data.shtc3.data);
+
+  Log.trace("shtc3 bus %dus", (int)shtc3.getBusTime());
+
+  if (err_code != SHTC3_SUCCESS)
+  {
+    Log.error("Error temp - fatal err");
+    this->abandonCycle();
+    return shtc3_error;
+  }
+
+  this->shtc3Complete();
+
+  return success;
+}
+
+// Process PM2.5 and PM10 results
+// This is slightly different from the other readings
+// due to the fact that it should be shut off when not taking a reading
+// (extends the life of the device)
+AirQualityWingError_t AirQualityWing::startHPMA115()
+{
+
+  uint32_t now = millis();
+
+  AirQualityWingError_t err = success;
+
+  // Previous reading is overdue. Can tie with the timeout at the minimum interval.
+  if (this->pending & AQW_PENDING_HPMA115)
+  {
+    this->hpmaTimeout();
+    err = hpma115_error;
+  }
+
+  this->openCycle(AQW_PENDING_HPMA115);
+  this->data.hpma115.hasData = false;
+
+  // Restart from a clean state
+  this->hpma115.disable();
+  this->hpma115.enable();
+  this->energy.start(ENERGY_HPMA115);
+
+  this->pending |= AQW_PENDING_HPMA115;
+  this->scheduler.start(AQW_TASK_HPMA_POLL, now, HPMA_POLL_INTERVAL_MS, HPMA_POLL_INTERVAL_MS);
+  this->scheduler.start(AQW_TASK_HPMA_TIMEOUT, now, HPMA_TIMEOUT_MS, 0);
+
+  return err;
+}
+
+AirQualityWingError_t AirQualityWing::runTask(uint8_t task)
+{
+
+  uint32_t err_code = success;
+
+  switch (task)
+  {
+  case AQW_TASK_SHTC3:
+    return this->startSHTC3();
+
+  case AQW_TASK_HPMA115:
+    return this->startHPMA115();
+
+  case AQW_TASK_SGP40:
+    // Queue a sample to feed the algorithm
+    err_code = sgp40.start();
+
+    if (err_code != SGP40_SUCCESS)
     {
-      err_code = sgp40.read(&this->data.sgp40.data);
-
-      if (err_code == SGP40_SUCCESS)
-      {
-        // Set has data flag
-        this->data.sgp40.hasData = true;
-      }
-      else if (err_code == SGP40_NO_DAT_AVAIL)
-      {
-        Log.warn("Error tvoc - no data");
-      }
-      else
-      {
-        Log.error("Error tvoc - fatal");
-        // return sgp40_error;
-      }
+      Log.error("sp40 process error. Error: %i", (int)err_code);
+      break;
     }
 
-    // Process PM2.5 and PM10 results
-    // This is slightly different from the other readings
-    // due to the fact that it should be shut off when not taking a reading
-    // (extends the life of the device)
-    if (this->settings_.hasHPMA115)
+    this->energy.start(ENERGY_SGP40);
+    this->kickBus();
+    break;
+
+  case AQW_TASK_I2C_BUS:
+    return this->processBus();
+
+  case AQW_TASK_HPMA_POLL:
+    // Processes any avilable serial data. Fires hpmaEvent() when done.
+    hpma115.process();
+    break;
+
+  case AQW_TASK_HPMA_TIMEOUT:
+    this->hpmaTimeout();
+    return hpma115_error;
+  }
+
+  return success;
+}
+
+// Runs the bus as soon as possible
+void AirQualityWing::kickBus()
+{
+  this->scheduler.start(AQW_TASK_I2C_BUS, millis(), 0, 0);
+}
+
+// Advances queued I2C transactions and collects finished ones
+AirQualityWingError_t AirQualityWing::processBus()
+{
+
+  AirQualityWingError_t err = success;
+  uint32_t err_code;
+
+  uint32_t started = micros();
+  this->bus.process();
+  this->energy.add(ENERGY_I2C, micros() - started);
+
+  if (shtc3.isPending())
+  {
+    err_code = shtc3.poll(&this->data.shtc3.data);
+
+    if (err_code == SHTC3_SUCCESS)
     {
-      this->hpma115.enable();
-      this->hpmaTimer->start();
+      Log.trace("shtc3 bus %dus", (int)shtc3.getBusTime());
+      this->pending &= ~AQW_PENDING_SHTC3;
+      this->shtc3Complete();
     }
-    else
+    else if (err_code != SHTC3_BUSY)
     {
-      this->measurementComplete = true;
+      Log.error("Error temp - poll err %d", (int)err_code);
+      this->abandonCycle();
+      err = shtc3_error;
     }
-
-    return success;
   }
 
-  if (this->settings_.hasSGP40)
+  if (sgp40.isPending())
   {
-    // Processes any avilable serial data
-    err_code = sgp40.process();
+    err_code = sgp40.poll();
 
-    if (err_code != SGP40_SUCCESS)
+    // Heater runs until the result is in
+    if (err_code != SGP40_BUSY)
+      this->energy.stop(ENERGY_SGP40);
+
+    // Always carries the latest index
+    if (err_code == SGP40_SUCCESS && sgp40.read(&this->data.sgp40.data) == SGP40_SUCCESS)
+    {
+      this->data.sgp40.hasData = true;
+      this->publish(AQW_EVENT_SGP40);
+    }
+    else if (err_code != SGP40_SUCCESS && err_code != SGP40_BUSY)
     {
       Log.error("sp40 process error. Error: %i", (int)err_code);
     }
   }
 
-  // Only run process command if this setup has HPMA115
-  if (this->settings_.hasHPMA115)
-    hpma115.process();
+  // Come back when the next transaction step is due
+  uint32_t due;
+  if (this->bus.nextDue(&due))
+  {
+    int32_t wait_us = due - micros();
+    uint32_t wait_ms = wait_us > 0 ? (wait_us + 999) / 1000 : 0;
+    this->scheduler.start(AQW_TASK_I2C_BUS, millis(), wait_ms, 0);
+  }
 
-  // Send event if complete
-  if (this->measurementComplete)
+  return err;
+}
+
+AirQualityWingError_t AirQualityWing::process()
+{
+
+  AirQualityWingError_t err = success;
+  AQW_STAT(uint32_t started = micros());
+
+  // One step per call
+  uint8_t task = this->scheduler.next(millis());
+  if (task != SCHEDULER_NONE)
+  {
+    err = this->runTask(task);
+  }
+
+  // Send event once everything due this cycle has reported
+  if (this->cycleActive && this->pending == 0 && this->expected == 0)
   {
 
     Log.trace("measurement complete");
 
-    // Set flag to false
-    this->measurementComplete = false;
+    this->cycleActive = false;
+    AQW_STAT(this->perf.cycles++);
+    AQW_STAT(perf_hist_add(&this->perf.cycle_ms, millis() - this->cycleStarted));
+    this->publish(AQW_EVENT_CYCLE);
+
+    // Needs wall clock time to be useful across resets
+    if (Time.isValid())
+      this->history.add(Time.now(), &this->data);
+
+    this->applyBudget();
 
-    // Only handle if we have an hpma
-    if (this->settings_.hasHPMA115)
+    // Only report what changed enough to matter
+    if (this->deadband.check(millis(), &this->data))
     {
-      // Stop timer
-      this->hpmaTimer->stop();
+      // Store and forward
+      if (this->log != nullptr && this->log->append(Time.isValid() ? Time.now() : 0, &this->data) != FLASH_LOG_SUCCESS)
+        Log.warn("flash log append failed");
+
+      // Output sinks
+      if (this->output != nullptr)
+        this->output->push(millis(), Time.isValid() ? Time.now() : 0, &this->data);
+
+      // Hand off to the application thread
+      if (this->worker.isRunning() && !this->results.push(this->data))
+        Log.warn("result queue full");
+
+      // Call handler
+      if (this->handler_ != nullptr)
+        this->handler_();
+    }
+  }
+
+  AQW_STAT(perf_hist_add(&this->perf.process_us, micros() - started));
+
+  return err;
+}
+
+uint16_t AirQualityWing::queryHistory(uint8_t tier, uint32_t from, uint32_t to, history_cb callback, void *p_context)
+{
+  return this->history.query(tier, from, to, callback, p_context);
+}
+
+bool AirQualityWing::aggregateHistory(uint8_t tier, uint8_t channel, uint32_t from, uint32_t to, history_stat_t *p_stat)
+{
+  return this->history.aggregate(tier, channel, from, to, p_stat);
+}
+
+AirQualityWingError_t AirQualityWing::process(uint32_t *p_wait_ms)
+{
+  AirQualityWingError_t err = this->process();
+
+  int32_t wait = this->nextDeadline() - millis();
+  *p_wait_ms = wait > 0 ? wait : 0;
+
+  return err;
+}
 
-      //If error show it here
-      if (this->hpmaError)
-      {
-        Log.error("hpma timeout");
+uint32_t AirQualityWing::suspend()
+{
+  AirQualityWingRetained_t *p_state = &aqw_retained;
+
+  this->scheduler.save(p_state->tasks);
+  p_state->cycleActive = this->cycleActive;
+  p_state->pending = this->pending;
+  p_state->expected = this->expected;
+  p_state->data = this->data;
+
+  // VOC baseline
+  p_state->hasVOCState = this->settings_.hasSGP40;
+  if (p_state->hasVOCState)
+    this->sgp40.getState(&p_state->vocState0, &p_state->vocState1);
+
+  this->aqi.getState(&p_state->aqi);
+  this->deadband.getState(&p_state->deadband);
+
+  p_state->savedMillis = millis();
+  p_state->savedTime = Time.isValid() ? Time.now() : 0;
+
+  int32_t wait = this->nextDeadline() - p_state->savedMillis;
+  p_state->wait = wait > 0 ? wait : 0;
+
+  p_state->magic = AQW_RETAINED_MAGIC;
+  p_state->version = AQW_RETAINED_VERSION;
+
+  this->suspended = true;
+
+  return p_state->wait;
+}
+
+bool AirQualityWing::resume()
+{
+  AirQualityWingRetained_t *p_state = &aqw_retained;
+
+  if (p_state->magic != AQW_RETAINED_MAGIC || p_state->version != AQW_RETAINED_VERSION)
+    return false;
+
+  // One shot, a later crash must not bring back stale state
+  p_state->magic = 0;
 
-        // Disable on error
-        this->hpma115.disable();
+  uint32_t now = millis();
 
-        // Reset error flag
-        this->hpmaError = false;
+  // Time asleep. Wall clock if there is one, otherwise assume the full sleep.
+  uint32_t elapsed = p_state->wait;
+  if (p_state->savedTime != 0 && Time.isValid())
+    elapsed = (Time.now() - p_state->savedTime) * 1000;
+  else if (this->suspended)
+    elapsed = now - p_state->savedMillis;
+
+  // Moves every due time so what was left of it is left after the sleep
+  uint32_t shift = now - p_state->savedMillis - elapsed;
+
+  if (this->suspended)
+  {
+    this->suspended = false;
 
-        // Return error
-        return hpma115_error;
-      }
+    // RAM made it through. Only fix the clock if it stopped while asleep,
+    // wall clock time is too coarse to correct small differences.
+    if ((int32_t)shift < -AQW_REBASE_TOLERANCE_MS || (int32_t)shift > AQW_REBASE_TOLERANCE_MS)
+    {
+      Log.info("resume: rebase %ldms", (long)(int32_t)shift);
+      this->scheduler.restore(p_state->tasks, shift);
     }
 
-    // Call handler
-    if (this->handler_ != nullptr)
-      this->handler_();
+    this->restartMeasurements(now);
+
+    return true;
   }
 
-  return success;
+  // Reset. setup() has run, bring back the rest.
+  Log.info("resume: after %lums", (unsigned long)elapsed);
+
+  this->scheduler.restore(p_state->tasks, shift);
+  this->cycleActive = p_state->cycleActive;
+  this->pending = p_state->pending;
+  this->expected = p_state->expected;
+  this->data = p_state->data;
+  this->published.write(this->data);
+
+  if (p_state->hasVOCState && this->settings_.hasSGP40 && elapsed < AQW_VOC_RESUME_MAX_MS)
+    this->sgp40.setState(p_state->vocState0, p_state->vocState1);
+
+  // Wall clock hours, nothing to rebase
+  this->aqi.setState(&p_state->aqi);
+
+  // Heartbeat counts from the last report as if millis() had kept going
+  deadband_state_t deadband = p_state->deadband;
+  deadband.reported_at += shift;
+  this->deadband.setState(&deadband);
+
+  this->restartMeasurements(now);
+
+  // Fan lost power, warm up from the start
+  if ((this->pending & AQW_PENDING_HPMA115) && !this->hpma115.is_enabled())
+  {
+    this->hpma115.enable();
+    this->energy.start(ENERGY_HPMA115);
+    this->scheduler.start(AQW_TASK_HPMA_POLL, now, HPMA_POLL_INTERVAL_MS, HPMA_POLL_INTERVAL_MS);
+    this->scheduler.start(AQW_TASK_HPMA_TIMEOUT, now, HPMA_TIMEOUT_MS, 0);
+  }
+
+  return true;
+}
+
+// Bus transactions in flight are stale after a sleep and gone after a reset.
+// Drops them and measures the SHTC3 again if the cycle was waiting on it.
+void AirQualityWing::restartMeasurements(uint32_t now)
+{
+  if (this->sgp40.isPending())
+  {
+    this->sgp40.abort();
+    this->energy.stop(ENERGY_SGP40);
+  }
+
+  this->shtc3.abort();
+
+  if (this->pending & AQW_PENDING_SHTC3)
+  {
+    this->pending &= ~AQW_PENDING_SHTC3;
+    this->scheduler.start(AQW_TASK_SHTC3, now, 0, this->sensorInterval(this->settings_.shtc3Interval));
+  }
+}
+
+uint32_t AirQualityWing::nextDeadline()
+{
+  uint32_t due;
+
+  // Nothing armed, nothing to wait for
+  if (!this->scheduler.nextDeadline(&due))
+    return millis();
+
+  return due;
+}
+
+uint32_t AirQualityWing::workerStep()
+{
+  AirQualityWingError_t err = this->process();
+
+  if (err != success)
+    Log.error("worker process err %d", (int)err);
+
+  // Sleep until there's something to do
+  int32_t wait = this->nextDeadline() - millis();
+
+  return wait > 0 ? wait : 0;
+}
+
+bool AirQualityWing::startWorker(os_thread_prio_t priority, size_t stack_size, result_queue_policy_t policy)
+{
+  this->results.setPolicy(policy);
+
+  return this->worker.start("aqw", [this](void) -> uint32_t
+                            { return workerStep(); },
+                            priority, stack_size);
+}
+
+void AirQualityWing::stopWorker()
+{
+  this->worker.stop();
+}
+
+bool AirQualityWing::receive(AirQualityWingData_t *p_data)
+{
+  return this->results.pop(p_data);
+}
+
+result_queue_stats_t AirQualityWing::getQueueStats(bool reset)
+{
+  return this->results.getStats(reset);
+}
+
+i2c_bus_stats_t AirQualityWing::getBusStats(bool reset)
+{
+  return this->bus.getStats(reset);
+}
+
+#if AQW_STATS_ENABLED
+AirQualityWingPerfStats_t AirQualityWing::getPerfStats(bool reset)
+{
+  AirQualityWingPerfStats_t stats = this->perf;
+
+  // Device counters live with the drivers
+  this->bus.getDeviceStats(SHTC3_ADDRESS, &stats.shtc3, reset);
+  this->bus.getDeviceStats(SGP40_ADDRESS, &stats.sgp40, reset);
+  stats.hpma115 = this->hpma115.getStats(reset);
+
+  if (reset)
+    memset(&this->perf, 0, sizeof(this->perf));
+
+  return stats;
+}
+#endif
+
+void AirQualityWing::setDeadband(uint8_t channel, int32_t threshold)
+{
+  this->deadband.setThreshold(channel, threshold);
+}
+
+void AirQualityWing::setHeartbeat(uint32_t heartbeat_ms)
+{
+  this->deadband.setHeartbeat(heartbeat_ms);
+}
+
+deadband_stats_t AirQualityWing::getDeadbandStats(bool reset)
+{
+  return this->deadband.getStats(reset);
+}
+
+energy_report_t AirQualityWing::getEnergyReport(bool reset)
+{
+  return this->energy.getReport(reset);
+}
+
+void AirQualityWing::setEnergyBudget(uint32_t daily_uah, uint32_t max_interval)
+{
+  this->energy.setBudget(daily_uah, max_interval);
+}
+
+void AirQualityWing::setStateOfCharge(float soc, float min_soc)
+{
+  this->energy.setStateOfCharge(soc, min_soc);
 }
 
 void AirQualityWing::setInterval(uint32_t interval)
@@ -327,12 +1039,43 @@ void AirQualityWing::setInterval(uint32_t interval)
   if (interval >= MIN_MEASUREMENT_DELAY_MS)
   {
 
-    // Set the interval
+    // Set the interval. The controller's range follows it.
     this->settings_.interval = interval;
+    this->setupAdaptive();
 
     Log.trace("update reading period %d\n", (int)interval);
 
-    // Change period if variable is updated
-    this->measurementTimer->changePeriod(interval);
+    this->setSHTC3Interval(interval);
+    this->setHPMA115Interval(interval);
+  }
+}
+
+void AirQualityWing::setSHTC3Interval(uint32_t interval)
+{
+
+  if (interval >= MIN_MEASUREMENT_DELAY_MS)
+  {
+    this->settings_.shtc3Interval = interval;
+    this->scheduler.setPeriod(AQW_TASK_SHTC3, millis(), this->sensorInterval(interval));
+  }
+}
+
+void AirQualityWing::setHPMA115Interval(uint32_t interval)
+{
+
+  if (interval >= MIN_MEASUREMENT_DELAY_MS)
+  {
+    this->settings_.hpma115Interval = interval;
+    this->scheduler.setPeriod(AQW_TASK_HPMA115, millis(), this->sensorInterval(interval));
   }
-}
\ No newline at end of file
+}
+
+void AirQualityWing::setSGP40Interval(uint32_t interval)
+{
+
+  if (interval >= MIN_SGP40_DELAY_MS)
+  {
+    this->settings_.sgp40Interval = interval;
+    this->scheduler.setPeriod(AQW_TASK_SGP40, millis(), interval);
+  }
+}
@@ -10,13 +10,46 @@
 #include "shtc3.h"
 #include "sgp40.h"
 #include "hpma115.h"
+#include "scheduler.h"
+#include "worker.h"
+#include "result_queue.h"
+#include "seqlock.h"
+#include "json_writer.h"
+#include "record_codec.h"
+#include "history.h"
+#include "stream_stats.h"
+#include "aqi.h"
+#include "deadband.h"
+#include "adaptive.h"
+#include "energy.h"
+#include "flash_log.h"
+#include "output_pipeline.h"
+#include "perf_stats.h"
 #include "stdbool.h"
 
 // Delay and timing related contsants
 #define MEASUREMENT_DELAY_S 120
 #define MEASUREMENT_DELAY_MS (MEASUREMENT_DELAY_S * 1000)
 #define MIN_MEASUREMENT_DELAY_MS 10000
+#define MIN_SGP40_DELAY_MS 100
 #define HPMA_TIMEOUT_MS 10000
+#define HPMA_POLL_INTERVAL_MS 50
+
+// Scheduler tasks
+enum
+{
+  AQW_TASK_SHTC3,
+  AQW_TASK_HPMA115,
+  AQW_TASK_HPMA_POLL,
+  AQW_TASK_HPMA_TIMEOUT,
+  AQW_TASK_SGP40,
+  AQW_TASK_I2C_BUS,
+};
+
+// Sensors in the current cycle. `pending` ones have started and not
+// reported yet, `expected` ones are due before the cycle ends but haven't started.
+#define AQW_PENDING_SHTC3 (1 << 0)
+#define AQW_PENDING_HPMA115 (1 << 1)
 
 typedef enum
 {
@@ -26,26 +59,6 @@ typedef enum
   hpma115_error,
 } AirQualityWingError_t;
 
-// Structure for holding data.
-typedef struct
-{
-  struct
-  {
-    bool hasData;
-    sgp40_data_t data;
-  } sgp40;
-  struct
-  {
-    bool hasData;
-    shtc3_data_t data;
-  } shtc3;
-  struct
-  {
-    bool hasData;
-    hpma115_data_t data;
-  } hpma115;
-} AirQualityWingData_t;
-
 typedef struct
 {
   uint32_t interval;
@@ -53,11 +66,125 @@ typedef struct
   bool hasSGP40;
   bool hasSHTC3;
   uint8_t hpma115IntPin;
+  bool shtc3LowPower;
+  bool shtc3Polled;
+
+  // Per sensor periods in ms. 0 uses `interval` (SGP40_READ_INTERVAL for the SGP40)
+  uint32_t shtc3Interval;
+  uint32_t hpma115Interval;
+  uint32_t sgp40Interval;
+
+  // Per sensor phase offsets in ms. 0 lets the scheduler spread them out.
+  uint32_t shtc3Phase;
+  uint32_t hpma115Phase;
+  uint32_t sgp40Phase;
+
+  // Window length in ms and quantile for the per channel statistics.
+  // 0 uses STREAM_STATS_WINDOW_MS and STREAM_STATS_QUANTILE.
+  uint32_t statsWindow;
+  float statsQuantile;
+
+  // Report by exception. A completed cycle only reaches the handler and the
+  // worker queue if an AQW_CHANNEL_* channel moved by its dead-band (fixed
+  // point units, 0 reports every change) or `heartbeat` ms passed (0 never).
+  int32_t deadband[AQW_CHANNEL_COUNT];
+  uint32_t heartbeat;
+
+  // Adaptive SHTC3/HPMA115 interval. Shortens while the VOC index slope
+  // (points/min) or the change between PM readings (µg/m³) is over its
+  // threshold, lengthens while quiet. 0 picks the defaults: min of
+  // MIN_MEASUREMENT_DELAY_MS, max of ADAPTIVE_MAX_FACTOR * interval,
+  // ADAPTIVE_VOC_SLOPE and ADAPTIVE_PM_DELTA. The controller works on
+  // `interval`, each sensor's own period is scaled by the same factor.
+  bool adaptive;
+  uint32_t adaptiveMin;
+  uint32_t adaptiveMax;
+  uint16_t adaptiveVOCSlope;
+  uint16_t adaptivePMDelta;
+
+  // Active currents in µA for the energy estimates. 0 uses ENERGY_*_UA.
+  uint32_t hpma115Current;
+  uint32_t sgp40Current;
+  uint32_t shtc3Current;
+  uint32_t i2cCurrent;
+
+  // Daily charge budget in µAh, 0 for none. Intervals are stretched up to
+  // `energyMaxInterval` (0 uses ENERGY_MAX_INTERVAL_MS), past that the HPMA115 is turned off.
+  uint32_t energyBudget;
+  uint32_t energyMaxInterval;
 } AirQualityWingSettings_t;
 
 // Handler defintion
 typedef std::function<void()> AirQualityWingHandler_t;
 
+// Events subscribers can listen for. Combine with |
+#define AQW_EVENT_SHTC3 (1 << 0)
+#define AQW_EVENT_SGP40 (1 << 1)
+#define AQW_EVENT_HPMA115 (1 << 2)
+#define AQW_EVENT_CYCLE (1 << 3)
+#define AQW_EVENT_ALL 0x0f
+
+#define AQW_MAX_SUBSCRIBERS 8
+
+// Receives the event that fired and the data with the new reading in it.
+// Runs on the process() thread, the reference is only valid during the call.
+typedef std::function<void(uint8_t event, const AirQualityWingData_t &data)> AirQualityWingSubscriber_t;
+
+typedef struct
+{
+  uint8_t events;
+  AirQualityWingSubscriber_t callback;
+} AirQualityWingSubscription_t;
+
+// Library state kept across System.sleep() and resets, see suspend()/resume()
+#define AQW_RETAINED_MAGIC 0x41515753
+#define AQW_RETAINED_VERSION 3
+
+// Retained RAM on Gen 3 (3068 bytes of backup SRAM). Split between the library
+// state (AirQualityWingRetained_t, about 320 bytes) and the history store
+// (history_store_t, about 2.5 KB at the default depths). Checked at compile
+// time, shrink the HISTORY_*_DEPTH options to make room for application data.
+#define AQW_RETAINED_BYTES 3068
+
+// The VOC baseline is only valid across short gaps
+#define AQW_VOC_RESUME_MAX_MS (10 * 60 * 1000)
+
+// Clock drift over a sleep that is left alone
+#define AQW_REBASE_TOLERANCE_MS 2000
+
+typedef struct
+{
+  uint32_t magic;
+  uint16_t version;
+  scheduler_task_t tasks[SCHEDULER_MAX_TASKS];
+  bool cycleActive;
+  uint8_t pending;
+  uint8_t expected;
+  AirQualityWingData_t data;
+  bool hasVOCState;
+  int32_t vocState0;
+  int32_t vocState1;
+  aqi_state_t aqi;
+  deadband_state_t deadband;
+  uint32_t savedMillis;
+  uint32_t savedTime; // Unix time, 0 if it wasn't valid
+  uint32_t wait;      // ms suspend() said to sleep
+} AirQualityWingRetained_t;
+
+#if AQW_STATS_ENABLED
+// Counters since the last reset, see getPerfStats()
+typedef struct
+{
+  perf_i2c_t shtc3;
+  perf_i2c_t sgp40; // `retries` are reads of a conversion that wasn't done yet
+  perf_uart_t hpma115;
+  uint32_t cycles;
+  uint32_t timeouts;       // HPMA115 readings that never showed up
+  perf_hist_t process_us;  // Time spent in process()
+  perf_hist_t cycle_ms;    // Measurement start to cycle completion
+} AirQualityWingPerfStats_t;
+#endif
+
 // Air quality class. Only create one of these!
 class AirQualityWing
 {
@@ -71,24 +198,84 @@ private:
   HPMA115 hpma115;
   SGP40 sgp40;
 
-  // Variables
-  Timer *measurementTimer;
-  Timer *hpmaTimer;
+  // Owns every sensor's next due time
+  Scheduler scheduler;
 
-  // Static measurement timer event function
-  void hpmaEvent();
-  void measureTimerEvent();
-  void hpmaTimerEvent();
-  void sgpTimerEvent();
+  // Shared by the SHTC3 and SGP40
+  I2CBus bus;
+  void kickBus();
+  AirQualityWingError_t processBus();
 
-  // Static var
-  bool measurementStart;
-  bool measurementComplete;
-  bool hpmaMeasurementComplete;
-  bool hpmaError;
+  // Measurement cycle
+  void openCycle(uint8_t sensor);
+  void abandonCycle();
+  AirQualityWingError_t startSHTC3();
+  AirQualityWingError_t startHPMA115();
+  AirQualityWingError_t runTask(uint8_t task);
+  void hpmaEvent();
+  void hpmaTimeout();
+  void shtc3Complete();
+  bool cycleActive;
+  uint8_t pending;
+  uint8_t expected;
 
-  // Data
+  // Data. Filled in field by field on the process() thread,
+  // readers only ever see `published`.
   AirQualityWingData_t data;
+  Seqlock<AirQualityWingData_t> published;
+  void publish(uint8_t event);
+
+  // Completed cycles, kept across resets
+  History history;
+
+  // Fed from every sensor result, not just completed cycles
+  StreamStats stats[AQW_CHANNEL_COUNT];
+  void updateStats(uint8_t event);
+
+  // NowCast/AQI, updated with every PM reading
+  AQI aqi;
+
+  // Gates the handler and the worker queue
+  Deadband deadband;
+
+  // Interval controller, only used if settings_.adaptive
+  AdaptiveSampler adaptive;
+  void adaptInterval(uint8_t event);
+  void setupAdaptive();
+
+  // Period a sensor runs at for its configured `base` period
+  uint32_t sensorInterval(uint32_t base);
+  void updateIntervals();
+
+  // Energy accounting and budget
+  EnergyMeter energy;
+  void applyBudget();
+  bool budgetStretched;
+  uint32_t budgetInterval; // Last plan
+  bool budgetHPMAOff;
+
+  // suspend() was called and RAM is still intact
+  bool suspended;
+  void restartMeasurements(uint32_t now);
+
+  // Store and forward, optional
+  FlashLog *log;
+
+  // Output sinks, optional
+  OutputPipeline *output;
+
+#if AQW_STATS_ENABLED
+  AirQualityWingPerfStats_t perf;
+  uint32_t cycleStarted;
+#endif
+
+  // Event subscribers
+  AirQualityWingSubscription_t subscribers[AQW_MAX_SUBSCRIBERS];
+
+  // Worker thread mode
+  Worker worker;
+  ResultQueue<AirQualityWingData_t> results;
+  uint32_t workerStep();
 
 public:
   // Using defaults
@@ -106,8 +293,23 @@ public:
   // Prints out a string representation in JSON of the data
   String toString();
 
-  // Returns a copy of the full data structure
+  // Same JSON into a caller provided buffer, JSON_MAX_SIZE always fits.
+  // `fields` is a mask of JSON_FIELD_*, add JSON_FIELD_AQI for the index.
+  // Returns bytes written, 0 if it didn't fit.
+  size_t toJSON(char *p_buf, size_t size, uint32_t fields = JSON_FIELD_ALL);
+
+  // Compact binary record of the data, see record_codec.h. RECORD_MAX_SIZE always fits.
+  // Returns bytes written, 0 if it didn't fit.
+  size_t toBinary(uint8_t *p_buf, size_t size);
+
+  // Returns a consistent copy of the latest data. Safe from any thread.
   AirQualityWingData_t getData();
+  AirQualityWingData_t getData(uint32_t *p_version);
+
+  // Counts published updates. Compare against a previous value to check
+  // for new data without copying it.
+  uint32_t getVersion();
+  bool hasNewData(uint32_t version);
 
   // Attaches event handler. Event handler fires when a round of data has completed successfully
   void attachHandler(AirQualityWingHandler_t handler);
@@ -115,12 +317,107 @@ public:
   // Deattaches event handler. The only way to fetch new data is using the `data()` method
   void deattachHandler();
 
+  // Appends every reported reading to `p_log` (begin() it first), nullptr to stop.
+  // Drain and ack it from the application.
+  void attachLog(FlashLog *p_log);
+
+  // Pushes every reported reading into `p_output`, nullptr to stop.
+  // Call p_output->process(millis()) from loop() to write them out.
+  void attachOutput(OutputPipeline *p_output);
+
+  // Subscribes to one or more AQW_EVENT_* events. Sensor events fire as soon
+  // as that sensor has a new reading, AQW_EVENT_CYCLE when the whole cycle is done.
+  // Returns a subscription id, -1 if all AQW_MAX_SUBSCRIBERS slots are taken.
+  int subscribe(uint8_t events, AirQualityWingSubscriber_t subscriber);
+  void unsubscribe(int id);
+
   // Process method is required to process data correctly. Place in `loop()` function
+  // Runs at most one scheduled step per call.
   AirQualityWingError_t process();
 
-  // Set measurement interval.
-  // Accepts intervals from 20 seconds
+  // Same, and sets `p_wait_ms` to the time until it next has work.
+  // Sleep that long instead of spinning in `loop()`.
+  AirQualityWingError_t process(uint32_t *p_wait_ms);
+
+  // millis() time at which process() next has work to do
+  uint32_t nextDeadline();
+
+  // Saves the library state to retained memory. Call right before System.sleep().
+  // Returns the ms until process() next has work, the longest the device should sleep.
+  uint32_t suspend();
+
+  // Picks up where suspend() left off: HPMA115 warm-up, the cycle in progress
+  // and every due time, rebased on the time spent asleep. SHTC3 and SGP40
+  // samples that were on the bus are dropped and the SHTC3 is measured again.
+  // After a wake that kept RAM, call before process(). After a reset
+  // (HIBERNATE), call after setup() in place of begin(). A reset also keeps
+  // the AQI hours and the last deadband report. The statistics windows
+  // start over, at 136 bytes a channel they don't fit next to the history.
+  // False if there was nothing to resume.
+  bool resume();
+
+  // Runs process() on a dedicated thread instead of `loop()`. Completed
+  // readings are queued for `receive()`. The handler runs on that thread.
+  bool startWorker(os_thread_prio_t priority = OS_THREAD_PRIORITY_DEFAULT,
+                   size_t stack_size = WORKER_STACK_SIZE,
+                   result_queue_policy_t policy = RESULT_QUEUE_OVERWRITE_OLDEST);
+  void stopWorker();
+
+  // Walks stored cycles of a HISTORY_* tier between two Unix times, oldest first.
+  // Call from the same thread as process().
+  uint16_t queryHistory(uint8_t tier, uint32_t from, uint32_t to, history_cb callback, void *p_context = nullptr);
+
+  // Min/mean/max of one AQW_CHANNEL_* channel over a time range
+  bool aggregateHistory(uint8_t tier, uint8_t channel, uint32_t from, uint32_t to, history_stat_t *p_stat);
+
+  // Mean/stddev/min/max/quantile of an AQW_CHANNEL_* channel over the last
+  // completed window, or the one in progress if `current`. False if it has no samples.
+  bool getChannelStats(uint8_t channel, stream_stats_t *p_stats, bool current = false);
+
+  // Changes one channel's window and quantile. Starts a fresh window.
+  void setStatsWindow(uint8_t channel, uint32_t window_ms, float quantile = STREAM_STATS_QUANTILE);
+
+  // Oldest completed reading from the worker. False if none are waiting.
+  bool receive(AirQualityWingData_t *p_data);
+  result_queue_stats_t getQueueStats(bool reset = false);
+
+  // I2C bus utilization and error counts since the last reset
+  i2c_bus_stats_t getBusStats(bool reset = false);
+
+#if AQW_STATS_ENABLED
+  // Per device I2C/UART counters, timeouts and latency histograms since the
+  // last reset. Not available when built with AQW_STATS_ENABLED 0.
+  AirQualityWingPerfStats_t getPerfStats(bool reset = false);
+#endif
+
+  // Dead-band of one AQW_CHANNEL_* channel, DEADBAND_IGNORE to never report on it
+  void setDeadband(uint8_t channel, int32_t threshold);
+
+  // Longest time in ms between reports, 0 to only report changes
+  void setHeartbeat(uint32_t heartbeat_ms);
+
+  // Reports sent and suppressed by the dead-band
+  deadband_stats_t getDeadbandStats(bool reset = false);
+
+  // On-time and estimated charge per ENERGY_* component since the last reset
+  energy_report_t getEnergyReport(bool reset = false);
+
+  // Daily budget in µAh (0 for none) and the longest interval it may stretch to
+  void setEnergyBudget(uint32_t daily_uah, uint32_t max_interval = ENERGY_MAX_INTERVAL_MS);
+
+  // Battery state of charge in %, e.g. from FuelGauge. Below `min_soc` the
+  // HPMA115 is turned off and the interval stretched to the maximum.
+  void setStateOfCharge(float soc, float min_soc);
+
+  // Set measurement interval for both the SHTC3 and HPMA115.
+  // Accepts intervals from 10 seconds
   void setInterval(uint32_t interval);
+
+  // Per sensor intervals. SHTC3 and HPMA115 accept intervals from 10 seconds.
+  // The SGP40 accepts intervals from 100ms, the VOC algorithm is tuned for 1 second.
+  void setSHTC3Interval(uint32_t interval);
+  void setHPMA115Interval(uint32_t interval);
+  void setSGP40Interval(uint32_t interval);
 };
 
 #endif
\ No newline at end of file
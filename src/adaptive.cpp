@@ -0,0 +1,104 @@
+/*
+ * Project Particle Squared
+ * Description: Adapts the measurement interval to how fast readings change
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "adaptive.h"
+
+AdaptiveSampler::AdaptiveSampler(void)
+{
+  this->setup(0, 0, 0, ADAPTIVE_VOC_SLOPE, ADAPTIVE_PM_DELTA);
+}
+
+void AdaptiveSampler::setup(uint32_t min_ms, uint32_t max_ms, uint32_t interval_ms, uint16_t voc_slope, uint16_t pm_delta)
+{
+  this->min_interval = min_ms;
+  this->max_interval = max_ms > min_ms ? max_ms : min_ms;
+  this->voc_threshold = voc_slope;
+  this->pm_threshold = pm_delta;
+
+  if (interval_ms < this->min_interval)
+    interval_ms = this->min_interval;
+  if (interval_ms > this->max_interval)
+    interval_ms = this->max_interval;
+  this->interval = interval_ms;
+
+  this->has_voc = false;
+  this->voc_slope = 0;
+  this->has_pm = false;
+  this->pm_delta = 0;
+  this->pm_judged = 0;
+}
+
+void AdaptiveSampler::addVOC(uint32_t now, int32_t tvoc)
+{
+  if (this->has_voc && now != this->last_voc_at)
+  {
+    float slope = (float)(tvoc - this->last_voc) * 60000 / (now - this->last_voc_at);
+    this->voc_slope += ADAPTIVE_VOC_ALPHA * (slope - this->voc_slope);
+  }
+
+  this->has_voc = true;
+  this->last_voc = tvoc;
+  this->last_voc_at = now;
+}
+
+void AdaptiveSampler::addPM(uint16_t pm25, uint16_t pm10)
+{
+  if (this->has_pm)
+  {
+    uint16_t delta25 = abs(pm25 - this->last_pm25);
+    uint16_t delta10 = abs(pm10 - this->last_pm10);
+    uint16_t delta = delta25 > delta10 ? delta25 : delta10;
+
+    if (delta > this->pm_delta)
+      this->pm_delta = delta;
+  }
+
+  this->has_pm = true;
+  this->last_pm25 = pm25;
+  this->last_pm10 = pm10;
+}
+
+adaptive_decision_t AdaptiveSampler::update()
+{
+  float voc = fabsf(this->voc_slope);
+  uint16_t pm = this->pm_delta;
+  adaptive_decision_t decision = ADAPTIVE_HOLD;
+
+  // Each cycle judges the PM change it saw
+  this->pm_judged = pm;
+  this->pm_delta = 0;
+
+  if (voc >= this->voc_threshold || pm >= this->pm_threshold)
+  {
+    if (this->interval > this->min_interval)
+    {
+      this->interval /= 2;
+      if (this->interval < this->min_interval)
+        this->interval = this->min_interval;
+
+      decision = ADAPTIVE_FASTER;
+    }
+  }
+  // Hysteresis band between half and full threshold holds
+  else if (voc * 2 < this->voc_threshold && pm * 2 < this->pm_threshold)
+  {
+    if (this->interval < this->max_interval)
+    {
+      this->interval += this->interval / 4;
+      if (this->interval > this->max_interval)
+        this->interval = this->max_interval;
+
+      decision = ADAPTIVE_SLOWER;
+    }
+  }
+
+  return decision;
+}
@@ -0,0 +1,74 @@
+/*
+ * Project Particle Squared
+ * Description: Adapts the measurement interval to how fast readings change
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef ADAPTIVE_H
+#define ADAPTIVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Defaults
+#define ADAPTIVE_VOC_SLOPE 10 // VOC index points per minute
+#define ADAPTIVE_PM_DELTA 5   // µg/m³ between readings
+#define ADAPTIVE_MAX_FACTOR 4 // Max interval as a multiple of the configured one
+
+// Smoothing of the 1 Hz VOC derivative, roughly a 10 sample time constant
+#define ADAPTIVE_VOC_ALPHA 0.1f
+
+typedef enum
+{
+  ADAPTIVE_HOLD,
+  ADAPTIVE_FASTER, // Something is happening
+  ADAPTIVE_SLOWER, // Quiet
+} adaptive_decision_t;
+
+class AdaptiveSampler
+{
+public:
+  AdaptiveSampler(void);
+
+  // Interval stays within [min_ms, max_ms], starting at `interval_ms`.
+  // `voc_slope` is in index points per minute, `pm_delta` in µg/m³.
+  void setup(uint32_t min_ms, uint32_t max_ms, uint32_t interval_ms, uint16_t voc_slope, uint16_t pm_delta);
+
+  // VOC index samples, any rate
+  void addVOC(uint32_t now, int32_t tvoc);
+
+  // Each PM reading
+  void addPM(uint16_t pm25, uint16_t pm10);
+
+  // Once per measurement cycle. Halves the interval while either signal is
+  // over its threshold, grows it by a quarter while both are under half of it.
+  adaptive_decision_t update();
+
+  uint32_t getInterval() { return this->interval; }
+  float getVOCSlope() { return this->voc_slope; }
+  uint16_t getPMDelta() { return this->pm_judged; } // As of the last update()
+
+private:
+  uint32_t min_interval;
+  uint32_t max_interval;
+  uint32_t interval;
+  uint16_t voc_threshold;
+  uint16_t pm_threshold;
+
+  // VOC index slope, points per minute
+  bool has_voc;
+  int32_t last_voc;
+  uint32_t last_voc_at;
+  float voc_slope;
+
+  // Largest PM change since the last update
+  bool has_pm;
+  uint16_t last_pm25;
+  uint16_t last_pm10;
+  uint16_t pm_delta;
+  uint16_t pm_judged;
+};
+
+#endif //ADAPTIVE_H
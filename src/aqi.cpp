@@ -0,0 +1,281 @@
+/*
+ * Project Particle Squared
+ * Description: Incremental NowCast and US EPA AQI for particulate matter
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include <string.h>
+
+#include "aqi.h"
+
+typedef struct
+{
+  uint16_t c_lo, c_hi;
+  uint16_t i_lo, i_hi;
+} aqi_breakpoint_t;
+
+#define AQI_BREAKPOINTS 6
+#define AQI_MAX 500
+
+// PM2.5 in tenths of µg/m³ (2024 revision)
+static const aqi_breakpoint_t aqi_pm25[AQI_BREAKPOINTS] = {
+    {0, 90, 0, 50},
+    {91, 354, 51, 100},
+    {355, 554, 101, 150},
+    {555, 1254, 151, 200},
+    {1255, 2254, 201, 300},
+    {2255, 3254, 301, 500},
+};
+
+// PM10 in µg/m³
+static const aqi_breakpoint_t aqi_pm10[AQI_BREAKPOINTS] = {
+    {0, 54, 0, 50},
+    {55, 154, 51, 100},
+    {155, 254, 101, 150},
+    {255, 354, 151, 200},
+    {355, 424, 201, 300},
+    {425, 604, 301, 500},
+};
+
+// Bucket units per µg/m³. PM2.5 is truncated to 0.1, PM10 to 1.
+static const uint8_t aqi_scale[AQI_POLLUTANT_COUNT] = {10, 1};
+
+uint16_t aqi_index(uint8_t pollutant, uint32_t concentration)
+{
+  const aqi_breakpoint_t *p_table = pollutant == AQI_PM25 ? aqi_pm25 : aqi_pm10;
+
+  for (uint8_t i = 0; i < AQI_BREAKPOINTS; i++)
+  {
+    const aqi_breakpoint_t *p_bp = &p_table[i];
+
+    if (concentration > p_bp->c_hi)
+      continue;
+
+    // Linear within the band, rounded to nearest
+    uint32_t span = (uint32_t)(p_bp->i_hi - p_bp->i_lo) * (concentration - p_bp->c_lo) * 2 / (p_bp->c_hi - p_bp->c_lo);
+    return p_bp->i_lo + (span + 1) / 2;
+  }
+
+  return AQI_MAX;
+}
+
+// Hourly average in bucket units. False if the hour has no readings.
+static bool bucket_average(const aqi_bucket_t *p_bucket, uint8_t pollutant, uint32_t *p_avg)
+{
+  if (p_bucket->count == 0)
+    return false;
+
+  *p_avg = p_bucket->sum * aqi_scale[pollutant] / p_bucket->count;
+
+  return true;
+}
+
+AQI::AQI(void)
+{
+  this->reset();
+}
+
+void AQI::reset()
+{
+  memset(this->buckets, 0, sizeof(this->buckets));
+  this->head = 0;
+  this->hour = 0;
+
+  for (uint8_t p = 0; p < AQI_POLLUTANT_COUNT; p++)
+    this->rollup(p);
+}
+
+// Moves the ring up to `hour`, clearing the hours that were skipped
+void AQI::advance(uint32_t hour)
+{
+  if (this->hour == hour)
+    return;
+
+  uint32_t elapsed = hour - this->hour;
+
+  if (this->hour == 0 || elapsed >= AQI_HOURS)
+  {
+    memset(this->buckets, 0, sizeof(this->buckets));
+  }
+  else
+  {
+    for (uint32_t i = 0; i < elapsed; i++)
+    {
+      this->head = (this->head + 1) % AQI_HOURS;
+
+      for (uint8_t p = 0; p < AQI_POLLUTANT_COUNT; p++)
+        this->buckets[p][this->head] = {0, 0};
+    }
+  }
+
+  this->hour = hour;
+
+  for (uint8_t p = 0; p < AQI_POLLUTANT_COUNT; p++)
+    this->rollup(p);
+}
+
+// Caches what the completed hours contribute. Once an hour.
+void AQI::rollup(uint8_t pollutant)
+{
+  this->day_sum[pollutant] = 0;
+  this->day_hours[pollutant] = 0;
+
+  for (uint8_t age = 1; age < AQI_HOURS; age++)
+  {
+    uint32_t avg;
+
+    if (!bucket_average(&this->buckets[pollutant][(this->head + AQI_HOURS - age) % AQI_HOURS], pollutant, &avg))
+      continue;
+
+    this->day_sum[pollutant] += avg;
+    this->day_hours[pollutant]++;
+  }
+
+  this->cast[pollutant] = this->nowcast(pollutant);
+}
+
+void AQI::add(uint32_t timestamp, uint16_t pm25, uint16_t pm10)
+{
+  this->advance(timestamp / AQI_HOUR_S);
+
+  aqi_bucket_t *p_bucket = &this->buckets[AQI_PM25][this->head];
+  p_bucket->sum += pm25;
+  p_bucket->count++;
+
+  p_bucket = &this->buckets[AQI_PM10][this->head];
+  p_bucket->sum += pm10;
+  p_bucket->count++;
+}
+
+// NowCast in bucket units, truncated, over the 12 completed hours. The
+// current partial hour isn't used. AQI_INVALID if two of the last three
+// completed hours are missing.
+uint32_t AQI::nowcast(uint8_t pollutant)
+{
+  uint32_t c[AQI_NOWCAST_HOURS];
+  bool valid[AQI_NOWCAST_HOURS];
+  uint32_t min = 0, max = 0;
+  bool first = true;
+
+  // c[0] is the hour that just ended
+  for (uint8_t i = 0; i < AQI_NOWCAST_HOURS; i++)
+  {
+    valid[i] = bucket_average(&this->buckets[pollutant][(this->head + AQI_HOURS - 1 - i) % AQI_HOURS], pollutant, &c[i]);
+
+    if (!valid[i])
+      continue;
+
+    if (first || c[i] < min)
+      min = c[i];
+    if (first || c[i] > max)
+      max = c[i];
+    first = false;
+  }
+
+  if (valid[0] + valid[1] + valid[2] < 2)
+    return AQI_INVALID;
+
+  if (max == 0)
+    return 0;
+
+  // Weight factor from the spread
+  float w = (float)min / max;
+  if (w < 0.5f)
+    w = 0.5f;
+
+  // Horner over sum(w^i * c[i]) / sum(w^i), missing hours skipped
+  float num = 0, den = 0;
+
+  for (int8_t i = AQI_NOWCAST_HOURS - 1; i >= 0; i--)
+  {
+    num = num * w + (valid[i] ? c[i] : 0);
+    den = den * w + (valid[i] ? 1 : 0);
+  }
+
+  return (uint32_t)(num / den);
+}
+
+bool AQI::get(aqi_data_t *p_data)
+{
+  uint32_t nowcast[AQI_POLLUTANT_COUNT];
+  uint16_t sub[AQI_POLLUTANT_COUNT];
+  uint16_t daily[AQI_POLLUTANT_COUNT];
+
+  for (uint8_t p = 0; p < AQI_POLLUTANT_COUNT; p++)
+  {
+    nowcast[p] = this->cast[p];
+    sub[p] = nowcast[p] == AQI_INVALID ? AQI_INVALID : aqi_index(p, nowcast[p]);
+
+    // Trailing 24 h average of hourly averages, the current hour included
+    uint32_t sum = this->day_sum[p], avg;
+    uint8_t hours = this->day_hours[p];
+
+    if (bucket_average(&this->buckets[p][this->head], p, &avg))
+    {
+      sum += avg;
+      hours++;
+    }
+
+    daily[p] = hours >= AQI_DAILY_MIN_HOURS ? sum / hours : AQI_INVALID;
+  }
+
+  p_data->pm25_nowcast = nowcast[AQI_PM25];
+  p_data->pm10_nowcast = nowcast[AQI_PM10];
+  p_data->pm25_24h = daily[AQI_PM25];
+  p_data->pm10_24h = daily[AQI_PM10];
+  p_data->pm25_aqi = sub[AQI_PM25];
+  p_data->pm10_aqi = sub[AQI_PM10];
+
+  if (sub[AQI_PM25] == AQI_INVALID)
+    p_data->aqi = sub[AQI_PM10];
+  else if (sub[AQI_PM10] == AQI_INVALID)
+    p_data->aqi = sub[AQI_PM25];
+  else
+    p_data->aqi = sub[AQI_PM25] > sub[AQI_PM10] ? sub[AQI_PM25] : sub[AQI_PM10];
+
+  return p_data->aqi != AQI_INVALID;
+}
+
+void AQI::getState(aqi_state_t *p_state)
+{
+  p_state->hour = this->hour;
+
+  for (uint8_t p = 0; p < AQI_POLLUTANT_COUNT; p++)
+  {
+    p_state->current[p] = this->buckets[p][this->head];
+
+    for (uint8_t age = 1; age < AQI_HOURS; age++)
+    {
+      uint32_t avg;
+
+      if (!bucket_average(&this->buckets[p][(this->head + AQI_HOURS - age) % AQI_HOURS], p, &avg))
+        avg = AQI_INVALID;
+      else if (avg >= AQI_INVALID)
+        avg = AQI_INVALID - 1;
+
+      p_state->past[p][age - 1] = avg;
+    }
+  }
+}
+
+void AQI::setState(const aqi_state_t *p_state)
+{
+  this->reset();
+  this->hour = p_state->hour;
+
+  for (uint8_t p = 0; p < AQI_POLLUTANT_COUNT; p++)
+  {
+    this->buckets[p][this->head] = p_state->current[p];
+
+    // A sum of `avg` over `scale` readings averages back to `avg`
+    for (uint8_t age = 1; age < AQI_HOURS; age++)
+    {
+      if (p_state->past[p][age - 1] != AQI_INVALID)
+        this->buckets[p][(this->head + AQI_HOURS - age) % AQI_HOURS] = {p_state->past[p][age - 1], aqi_scale[p]};
+    }
+
+    this->rollup(p);
+  }
+}
@@ -0,0 +1,86 @@
+/*
+ * Project Particle Squared
+ * Description: Incremental NowCast and US EPA AQI for particulate matter
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef AQI_H
+#define AQI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "aqw_data.h"
+
+// Hourly buckets kept. NowCast uses the latest 12 completed hours, the
+// daily average all 24 including the current one.
+#define AQI_HOURS 24
+#define AQI_NOWCAST_HOURS 12
+
+// Daily average needs 75% of the hours
+#define AQI_DAILY_MIN_HOURS 18
+
+#define AQI_HOUR_S 3600
+
+// Pollutants
+enum
+{
+  AQI_PM25,
+  AQI_PM10,
+  AQI_POLLUTANT_COUNT,
+};
+
+typedef struct
+{
+  uint32_t sum;
+  uint16_t count;
+} aqi_bucket_t;
+
+// Compact copy of the buckets for keeping them across a reset. Completed
+// hours are kept as their average, the current one as is.
+typedef struct
+{
+  uint32_t hour; // Current hour, 0 if empty
+  aqi_bucket_t current[AQI_POLLUTANT_COUNT];
+  uint16_t past[AQI_POLLUTANT_COUNT][AQI_HOURS - 1]; // Bucket units by age - 1, AQI_INVALID if empty
+} aqi_state_t;
+
+// Sub-index for a concentration, PM2.5 in tenths of µg/m³, PM10 in µg/m³.
+// Uses the 2024 breakpoints, capped at 500.
+uint16_t aqi_index(uint8_t pollutant, uint32_t concentration);
+
+class AQI
+{
+public:
+  AQI(void);
+
+  void reset();
+
+  // One PM reading in µg/m³ at `timestamp` (seconds, must not go backwards)
+  void add(uint32_t timestamp, uint16_t pm25, uint16_t pm10);
+
+  // NowCast, daily averages and AQI for the buckets so far.
+  // False if there isn't enough data for a NowCast yet.
+  bool get(aqi_data_t *p_data);
+
+  void getState(aqi_state_t *p_state);
+  void setState(const aqi_state_t *p_state);
+
+private:
+  void advance(uint32_t hour);
+  void rollup(uint8_t pollutant);
+  uint32_t nowcast(uint8_t pollutant);
+
+  aqi_bucket_t buckets[AQI_POLLUTANT_COUNT][AQI_HOURS];
+  uint8_t head; // Bucket for the current hour
+  uint32_t hour;
+
+  // Over the completed hours, redone once an hour so
+  // each reading only has to fold in the current one
+  uint32_t cast[AQI_POLLUTANT_COUNT]; // NowCast, bucket units
+  uint32_t day_sum[AQI_POLLUTANT_COUNT];
+  uint8_t day_hours[AQI_POLLUTANT_COUNT];
+};
+
+#endif //AQI_H
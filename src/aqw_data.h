@@ -0,0 +1,139 @@
+/*
+ * Project Particle Squared
+ * Description: Reading types shared by the drivers, encoders and host tools
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef AQW_DATA_H
+#define AQW_DATA_H
+
+// No Device OS dependencies so host tools can use it
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct
+{
+  uint8_t raw_temperature[3];
+  uint8_t raw_humidity[3];
+  int16_t temperature; // centi-°C
+  uint16_t humidity;   // centi-%RH
+} shtc3_data_t;
+
+typedef struct
+{
+  uint16_t raw_tvoc;
+  int32_t tvoc;
+} sgp40_data_t;
+
+typedef struct
+{
+  uint16_t pm25; // µg/m³
+  uint16_t pm10; // µg/m³
+} hpma115_data_t;
+
+// AQI_INVALID where there isn't enough data
+typedef struct
+{
+  uint16_t pm25_nowcast; // Tenths of µg/m³
+  uint16_t pm10_nowcast; // µg/m³
+  uint16_t pm25_24h;     // Tenths of µg/m³
+  uint16_t pm10_24h;     // µg/m³
+  uint16_t pm25_aqi;
+  uint16_t pm10_aqi;
+  uint16_t aqi; // Worse of the two NowCast sub-indexes
+} aqi_data_t;
+
+#define AQI_INVALID 0xffff
+
+// Channels, in the same order as record_schema
+enum
+{
+  AQW_CHANNEL_PM25,
+  AQW_CHANNEL_PM10,
+  AQW_CHANNEL_TEMPERATURE,
+  AQW_CHANNEL_HUMIDITY,
+  AQW_CHANNEL_TVOC,
+  AQW_CHANNEL_COUNT,
+};
+
+// Structure for holding data.
+typedef struct
+{
+  struct
+  {
+    bool hasData;
+    sgp40_data_t data;
+  } sgp40;
+  struct
+  {
+    bool hasData;
+    shtc3_data_t data;
+  } shtc3;
+  struct
+  {
+    bool hasData;
+    hpma115_data_t data;
+  } hpma115;
+  struct
+  {
+    bool hasData;
+    aqi_data_t data;
+  } aqi;
+} AirQualityWingData_t;
+
+// Pulls one channel out of a reading. False if its sensor had no data.
+static inline bool aqw_channel_get(const AirQualityWingData_t *p_data, uint8_t channel, int32_t *p_value)
+{
+  switch (channel)
+  {
+  case AQW_CHANNEL_PM25:
+    *p_value = p_data->hpma115.data.pm25;
+    return p_data->hpma115.hasData;
+  case AQW_CHANNEL_PM10:
+    *p_value = p_data->hpma115.data.pm10;
+    return p_data->hpma115.hasData;
+  case AQW_CHANNEL_TEMPERATURE:
+    *p_value = p_data->shtc3.data.temperature;
+    return p_data->shtc3.hasData;
+  case AQW_CHANNEL_HUMIDITY:
+    *p_value = p_data->shtc3.data.humidity;
+    return p_data->shtc3.hasData;
+  case AQW_CHANNEL_TVOC:
+    *p_value = p_data->sgp40.data.tvoc;
+    return p_data->sgp40.hasData;
+  }
+
+  return false;
+}
+
+// Writes one channel into a reading and marks its sensor as having data
+static inline void aqw_channel_set(AirQualityWingData_t *p_data, uint8_t channel, int32_t value)
+{
+  switch (channel)
+  {
+  case AQW_CHANNEL_PM25:
+    p_data->hpma115.data.pm25 = value;
+    p_data->hpma115.hasData = true;
+    break;
+  case AQW_CHANNEL_PM10:
+    p_data->hpma115.data.pm10 = value;
+    p_data->hpma115.hasData = true;
+    break;
+  case AQW_CHANNEL_TEMPERATURE:
+    p_data->shtc3.data.temperature = value;
+    p_data->shtc3.hasData = true;
+    break;
+  case AQW_CHANNEL_HUMIDITY:
+    p_data->shtc3.data.humidity = value;
+    p_data->shtc3.hasData = true;
+    break;
+  case AQW_CHANNEL_TVOC:
+    p_data->sgp40.data.tvoc = value;
+    p_data->sgp40.hasData = true;
+    break;
+  }
+}
+
+#endif //AQW_DATA_H
@@ -0,0 +1,290 @@
+/*
+ * Project Particle Squared
+ * Description: Gorilla style compression of timestamped reading batches
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include <string.h>
+#include "batch_encoder.h"
+
+// Channel presence bits
+#define BATCH_HAS_HPMA115 (1 << 2)
+#define BATCH_HAS_SHTC3 (1 << 1)
+#define BATCH_HAS_SGP40 (1 << 0)
+
+// Channels are coded in AQW_CHANNEL_* order
+static_assert(BATCH_CHANNEL_COUNT == AQW_CHANNEL_COUNT, "batch must cover every channel");
+
+BatchEncoder::BatchEncoder(void) : p_buf(nullptr), size(0)
+{
+  memset(&this->state, 0, sizeof(this->state));
+}
+
+void BatchEncoder::begin(uint8_t *p_buf, size_t size)
+{
+  this->p_buf = p_buf;
+  this->size = size;
+
+  memset(&this->state, 0, sizeof(this->state));
+  this->state.bit_pos = BATCH_HEADER_SIZE * 8;
+  this->state.overflow = size < BATCH_HEADER_SIZE;
+}
+
+void BatchEncoder::putBits(uint32_t value, uint8_t bits)
+{
+  while (bits--)
+  {
+    uint32_t byte = this->state.bit_pos / 8;
+    uint8_t mask = 0x80 >> (this->state.bit_pos % 8);
+
+    if (byte >= this->size)
+    {
+      this->state.overflow = true;
+      return;
+    }
+
+    // Set or clear, a rolled back add may have left bits behind
+    if ((value >> bits) & 1)
+      this->p_buf[byte] |= mask;
+    else
+      this->p_buf[byte] &= ~mask;
+
+    this->state.bit_pos++;
+  }
+}
+
+void BatchEncoder::putDelta(int32_t delta)
+{
+  if (delta == 0)
+  {
+    this->putBits(0, 1);
+  }
+  else if (delta >= -64 && delta <= 63)
+  {
+    this->putBits(0b10, 2);
+    this->putBits(delta & 0x7f, 7);
+  }
+  else if (delta >= -256 && delta <= 255)
+  {
+    this->putBits(0b110, 3);
+    this->putBits(delta & 0x1ff, 9);
+  }
+  else if (delta >= -2048 && delta <= 2047)
+  {
+    this->putBits(0b1110, 4);
+    this->putBits(delta & 0xfff, 12);
+  }
+  else
+  {
+    this->putBits(0b1111, 4);
+    this->putBits(delta, 32);
+  }
+}
+
+bool BatchEncoder::add(uint32_t timestamp, const AirQualityWingData_t *p_data)
+{
+  if (this->state.overflow || this->state.count >= BATCH_MAX_READINGS)
+    return false;
+
+  batch_state_t saved = this->state;
+
+  if (this->state.count == 0)
+  {
+    // First timestamp goes in the header
+    for (uint8_t i = 0; i < 4; i++)
+      this->p_buf[2 + i] = timestamp >> (8 * i);
+  }
+  else
+  {
+    // Deltas wrap like the values do, the decoder wraps them back
+    int32_t delta = timestamp - this->state.last_timestamp;
+    this->putDelta((int32_t)((uint32_t)delta - (uint32_t)this->state.last_delta));
+    this->state.last_delta = delta;
+  }
+
+  this->state.last_timestamp = timestamp;
+
+  int32_t values[BATCH_CHANNEL_COUNT];
+  bool present[BATCH_CHANNEL_COUNT];
+
+  for (uint8_t i = 0; i < BATCH_CHANNEL_COUNT; i++)
+    present[i] = aqw_channel_get(p_data, i, &values[i]);
+
+  uint8_t presence = (present[AQW_CHANNEL_PM25] ? BATCH_HAS_HPMA115 : 0) |
+                     (present[AQW_CHANNEL_TEMPERATURE] ? BATCH_HAS_SHTC3 : 0) |
+                     (present[AQW_CHANNEL_TVOC] ? BATCH_HAS_SGP40 : 0);
+  this->putBits(presence, 3);
+
+  for (uint8_t i = 0; i < BATCH_CHANNEL_COUNT; i++)
+  {
+    if (!present[i])
+      continue;
+
+    this->putDelta((int32_t)((uint32_t)values[i] - (uint32_t)this->state.prev[i]));
+    this->state.prev[i] = values[i];
+  }
+
+  if (this->state.overflow)
+  {
+    this->state = saved;
+    return false;
+  }
+
+  this->state.count++;
+
+  return true;
+}
+
+size_t BatchEncoder::finish()
+{
+  if (this->size < BATCH_HEADER_SIZE)
+    return 0;
+
+  this->p_buf[0] = BATCH_VERSION;
+  this->p_buf[1] = this->state.count;
+
+  return (this->state.bit_pos + 7) / 8;
+}
+
+uint16_t BatchEncoder::count()
+{
+  return this->state.count;
+}
+
+typedef struct
+{
+  const uint8_t *p_buf;
+  size_t len;
+  uint32_t bit_pos;
+  bool truncated;
+} batch_reader_t;
+
+static uint32_t get_bits(batch_reader_t *p_reader, uint8_t bits)
+{
+  uint32_t value = 0;
+
+  while (bits--)
+  {
+    uint32_t byte = p_reader->bit_pos / 8;
+
+    if (byte >= p_reader->len)
+    {
+      p_reader->truncated = true;
+      return 0;
+    }
+
+    value = (value << 1) | ((p_reader->p_buf[byte] >> (7 - p_reader->bit_pos % 8)) & 1);
+    p_reader->bit_pos++;
+  }
+
+  return value;
+}
+
+// Sign extends the low `bits` bits
+static int32_t sign_extend(uint32_t value, uint8_t bits)
+{
+  uint32_t sign = 1u << (bits - 1);
+  return (int32_t)((value ^ sign) - sign);
+}
+
+static int32_t get_delta(batch_reader_t *p_reader)
+{
+  if (get_bits(p_reader, 1) == 0)
+    return 0;
+  if (get_bits(p_reader, 1) == 0)
+    return sign_extend(get_bits(p_reader, 7), 7);
+  if (get_bits(p_reader, 1) == 0)
+    return sign_extend(get_bits(p_reader, 9), 9);
+  if (get_bits(p_reader, 1) == 0)
+    return sign_extend(get_bits(p_reader, 12), 12);
+
+  return (int32_t)get_bits(p_reader, 32);
+}
+
+uint32_t batch_decode(const uint8_t *p_buf, size_t len, batch_reading_cb callback, void *p_context)
+{
+  if (len < BATCH_HEADER_SIZE)
+    return BATCH_TRUNCATED;
+
+  if (p_buf[0] != BATCH_VERSION)
+    return BATCH_BAD_VERSION;
+
+  batch_reader_t reader = {p_buf, len, BATCH_HEADER_SIZE * 8, false};
+  uint8_t count = p_buf[1];
+  uint32_t timestamp = p_buf[2] | (p_buf[3] << 8) | (p_buf[4] << 16) | ((uint32_t)p_buf[5] << 24);
+  int32_t delta = 0;
+  int32_t prev[BATCH_CHANNEL_COUNT] = {0};
+
+  for (uint8_t n = 0; n < count; n++)
+  {
+    if (n > 0)
+    {
+      delta = (int32_t)((uint32_t)delta + (uint32_t)get_delta(&reader));
+      timestamp += delta;
+    }
+
+    uint8_t presence = get_bits(&reader, 3);
+
+    bool present[BATCH_CHANNEL_COUNT] = {
+        (presence & BATCH_HAS_HPMA115) != 0,
+        (presence & BATCH_HAS_HPMA115) != 0,
+        (presence & BATCH_HAS_SHTC3) != 0,
+        (presence & BATCH_HAS_SHTC3) != 0,
+        (presence & BATCH_HAS_SGP40) != 0,
+    };
+
+    for (uint8_t i = 0; i < BATCH_CHANNEL_COUNT; i++)
+    {
+      if (present[i])
+        prev[i] = (int32_t)((uint32_t)prev[i] + (uint32_t)get_delta(&reader));
+    }
+
+    if (reader.truncated)
+      return BATCH_TRUNCATED;
+
+    AirQualityWingData_t data;
+    memset(&data, 0, sizeof(data));
+
+    for (uint8_t i = 0; i < BATCH_CHANNEL_COUNT; i++)
+    {
+      if (present[i])
+        aqw_channel_set(&data, i, prev[i]);
+    }
+
+    callback(timestamp, &data, p_context);
+  }
+
+  return BATCH_SUCCESS;
+}
+
+size_t batch_base64(const uint8_t *p_buf, size_t len, char *p_out, size_t size)
+{
+  static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+  size_t out_len = ((len + 2) / 3) * 4;
+
+  if (out_len + 1 > size)
+    return 0;
+
+  char *p = p_out;
+
+  for (size_t i = 0; i < len; i += 3)
+  {
+    uint32_t group = (uint32_t)p_buf[i] << 16;
+    if (i + 1 < len)
+      group |= (uint32_t)p_buf[i + 1] << 8;
+    if (i + 2 < len)
+      group |= p_buf[i + 2];
+
+    *p++ = alphabet[(group >> 18) & 0x3f];
+    *p++ = alphabet[(group >> 12) & 0x3f];
+    *p++ = i + 1 < len ? alphabet[(group >> 6) & 0x3f] : '=';
+    *p++ = i + 2 < len ? alphabet[group & 0x3f] : '=';
+  }
+
+  *p = '\0';
+
+  return out_len;
+}
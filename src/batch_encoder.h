@@ -0,0 +1,91 @@
+/*
+ * Project Particle Squared
+ * Description: Gorilla style compression of timestamped reading batches
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef BATCH_ENCODER_H
+#define BATCH_ENCODER_H
+
+#include <stddef.h>
+#include "aqw_data.h"
+
+// Layout (version 1):
+//   [0]    version
+//   [1]    reading count
+//   [2..5] first timestamp, little endian
+//   [6..]  bit stream, MSB first. Per reading:
+//            timestamp delta of delta (skipped for the first reading)
+//            3 presence bits: hpma115, shtc3, sgp40
+//            delta from the channel's previous value for every present
+//            channel: pm25, pm10, temperature, humidity, tvoc
+// Deltas use variable length buckets:
+//   0            -> 0
+//   10   + 7 bit -> [-64, 63]
+//   110  + 9 bit -> [-256, 255]
+//   1110 + 12 bit-> [-2048, 2047]
+//   1111 + 32 bit-> anything else
+#define BATCH_VERSION 1
+#define BATCH_HEADER_SIZE 6
+#define BATCH_MAX_READINGS 255
+#define BATCH_CHANNEL_COUNT 5
+
+// Particle.publish() data limit. Override for other Device OS versions.
+#ifndef BATCH_PUBLISH_DATA_LENGTH
+#define BATCH_PUBLISH_DATA_LENGTH 622
+#endif
+
+// Largest batch that still fits a publish once base64 encoded
+#define BATCH_MAX_SIZE ((BATCH_PUBLISH_DATA_LENGTH / 4) * 3)
+
+// Error codes
+#define BATCH_SUCCESS 0
+#define BATCH_TRUNCATED 1
+#define BATCH_BAD_VERSION 2
+
+typedef void (*batch_reading_cb)(uint32_t timestamp, const AirQualityWingData_t *p_data, void *p_context);
+
+typedef struct
+{
+  uint32_t bit_pos;
+  uint32_t last_timestamp;
+  int32_t last_delta;
+  int32_t prev[BATCH_CHANNEL_COUNT];
+  uint16_t count;
+  bool overflow;
+} batch_state_t;
+
+// Packs readings into a caller provided buffer until it's full
+class BatchEncoder
+{
+public:
+  BatchEncoder(void);
+
+  void begin(uint8_t *p_buf, size_t size);
+
+  // False if the reading didn't fit. The batch is left as it was.
+  bool add(uint32_t timestamp, const AirQualityWingData_t *p_data);
+
+  // Completes the header. Returns the batch size in bytes.
+  size_t finish();
+
+  uint16_t count();
+
+private:
+  void putBits(uint32_t value, uint8_t bits);
+  void putDelta(int32_t delta);
+  uint8_t *p_buf;
+  size_t size;
+  batch_state_t state;
+};
+
+// Calls `callback` for every reading in the batch
+uint32_t batch_decode(const uint8_t *p_buf, size_t len, batch_reading_cb callback, void *p_context);
+
+// Text safe form for publishing. Returns characters written without the
+// terminator, 0 if it didn't fit.
+size_t batch_base64(const uint8_t *p_buf, size_t len, char *p_out, size_t size);
+
+#endif //BATCH_ENCODER_H
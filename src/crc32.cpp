@@ -0,0 +1,25 @@
+/*
+ * Project Particle Squared
+ * Description: CRC-32 (IEEE 802.3, as used by zlib)
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include "crc32.h"
+
+// Table lives in flash, no runtime init
+static constexpr crc32_table_t crc32_table;
+
+static_assert(crc32_table.entry[1] == 0x77073096, "crc32 table");
+static_assert(crc32_table.entry[255] == 0x2d02ef8d, "crc32 table");
+
+uint32_t crc32(const uint8_t *data, size_t len, uint32_t crc)
+{
+    crc ^= CRC32_INIT;
+
+    while (len--)
+        crc = crc32_table.entry[(crc ^ *data++) & 0xff] ^ (crc >> 8);
+
+    return crc ^ CRC32_INIT;
+}
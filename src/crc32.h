@@ -0,0 +1,40 @@
+/*
+ * Project Particle Squared
+ * Description: CRC-32 (IEEE 802.3, as used by zlib)
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define CRC32_INIT 0xffffffff
+#define CRC32_POLY 0xedb88320 // Reflected
+
+// Lookup table generated by the compiler. One entry per byte value.
+struct crc32_table_t
+{
+  uint32_t entry[256];
+
+  constexpr crc32_table_t() : entry()
+  {
+    for (int i = 0; i < 256; i++)
+    {
+      uint32_t crc = i;
+
+      for (int bit = 0; bit < 8; bit++)
+        crc = (crc & 1) ? (crc >> 1) ^ CRC32_POLY : crc >> 1;
+
+      this->entry[i] = crc;
+    }
+  }
+};
+
+// CRC of a buffer. Pass a previous result as `crc` to continue over several buffers.
+uint32_t crc32(const uint8_t *data, size_t len, uint32_t crc = 0);
+
+#endif //CRC32_H
@@ -9,8 +9,12 @@
 
 #include "crc8_dallas.h"
 
-#define CRC8_DALLAS_INIT 0xff
-#define CRC8_DALLAS_POLY 0x31
+// Table lives in flash, no runtime init
+static constexpr crc8_dallas_table_t crc8_table;
+
+// Reference values from the Sensirion datasheets
+static_assert(crc8_table.entry[0x00] == 0x00, "crc8 table");
+static_assert(crc8_table.entry[crc8_table.entry[CRC8_DALLAS_INIT ^ 0xBE] ^ 0xEF] == 0x92, "crc8 0xBEEF");
 
 // Little Endian CRC8 Calculation For The SGP30
 uint8_t crc8_dallas_little(uint8_t *data, uint16_t size)
@@ -18,25 +22,63 @@ uint8_t crc8_dallas_little(uint8_t *data, uint16_t size)
     // Initializing (Typical start values 0x00 and 0xff)
     uint8_t crc = CRC8_DALLAS_INIT;
 
+    // Walk backwards so the MSB goes first
+    while (size--)
+        crc = crc8_table.entry[crc ^ data[size]];
+
+    return crc;
+}
+
+uint8_t crc8_dallas(const uint8_t *data, uint16_t size)
+{
+    uint8_t crc = CRC8_DALLAS_INIT;
+
     while (size--)
+        crc = crc8_table.entry[crc ^ *data++];
+
+    return crc;
+}
+
+uint32_t crc8_check_words(const uint8_t *p_buf, uint16_t count)
+{
+    while (count--)
     {
-        // Increment to the next byte
-        crc ^= *(data+size);
-
-        // Iterate through all bits
-        for (int i = 0; i < 8; i++)
-        {
-            // First bit always needs to be 1 for CRC checks
-            // Note: left shift so we can retain the remainder
-            // The operation "Carries over" into the next byte
-            // by an XOR operation
-            if (crc & 0x80) {
-              crc = (crc << 1) ^ CRC8_DALLAS_POLY;
-            } else {
-              // Otherwise shift to the next position
-              crc <<= 1;
-            }
-        }
+        uint8_t crc = crc8_table.entry[CRC8_DALLAS_INIT ^ p_buf[0]];
+        crc = crc8_table.entry[crc ^ p_buf[1]];
+
+        if (crc != p_buf[2])
+            return CRC8_MISMATCH;
+
+        p_buf += CRC8_WORD_SIZE;
     }
-    return crc;
-}
\ No newline at end of file
+
+    return CRC8_SUCCESS;
+}
+
+uint32_t crc8_unpack_words(const uint8_t *p_buf, uint16_t count, uint16_t *p_words)
+{
+    // Verify everything first so a bad word never leaks out
+    if (crc8_check_words(p_buf, count) != CRC8_SUCCESS)
+        return CRC8_MISMATCH;
+
+    while (count--)
+    {
+        *p_words++ = (p_buf[0] << 8) | p_buf[1];
+        p_buf += CRC8_WORD_SIZE;
+    }
+
+    return CRC8_SUCCESS;
+}
+
+void crc8_append_words(const uint16_t *p_words, uint16_t count, uint8_t *p_out)
+{
+    while (count--)
+    {
+        p_out[0] = *p_words >> 8;
+        p_out[1] = *p_words & 0xff;
+        p_out[2] = crc8_table.entry[crc8_table.entry[CRC8_DALLAS_INIT ^ p_out[0]] ^ p_out[1]];
+
+        p_words++;
+        p_out += CRC8_WORD_SIZE;
+    }
+}
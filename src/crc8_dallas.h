@@ -11,8 +11,50 @@
 #define CRC8_DALLAS_H
 
 #include <stdint.h>
-#include "application.h"
 
+#define CRC8_DALLAS_INIT 0xff
+#define CRC8_DALLAS_POLY 0x31
+
+// Sensirion words are 2 data bytes (MSB first) followed by their CRC
+#define CRC8_WORD_SIZE 3
+
+// Error codes
+#define CRC8_SUCCESS 0
+#define CRC8_MISMATCH 1
+
+// Lookup table generated by the compiler. One entry per byte value.
+struct crc8_dallas_table_t
+{
+  uint8_t entry[256];
+
+  constexpr crc8_dallas_table_t() : entry()
+  {
+    for (int i = 0; i < 256; i++)
+    {
+      uint8_t crc = i;
+
+      for (int bit = 0; bit < 8; bit++)
+        crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ CRC8_DALLAS_POLY) : (uint8_t)(crc << 1);
+
+      this->entry[i] = crc;
+    }
+  }
+};
+
+// CRC over a buffer stored in reverse byte order (i.e. a little endian uint16_t)
 uint8_t crc8_dallas_little(uint8_t *data, uint16_t len);
 
-#endif //CRC8_DALLAS_H
\ No newline at end of file
+// CRC over a buffer in wire order
+uint8_t crc8_dallas(const uint8_t *data, uint16_t len);
+
+// Checks `count` consecutive Sensirion words in one pass
+uint32_t crc8_check_words(const uint8_t *p_buf, uint16_t count);
+
+// Checks `count` Sensirion words and copies the data out as uint16_t
+uint32_t crc8_unpack_words(const uint8_t *p_buf, uint16_t count, uint16_t *p_words);
+
+// Packs `count` uint16_t values into Sensirion words, CRC included.
+// `p_out` must hold count * CRC8_WORD_SIZE bytes
+void crc8_append_words(const uint16_t *p_words, uint16_t count, uint8_t *p_out);
+
+#endif //CRC8_DALLAS_H
@@ -0,0 +1,108 @@
+/*
+ * Project Particle Squared
+ * Description: Report by exception filter for completed readings
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "deadband.h"
+
+Deadband::Deadband(void) : heartbeat(0)
+{
+  memset(this->threshold, 0, sizeof(this->threshold));
+  memset(&this->stats, 0, sizeof(this->stats));
+  this->reset();
+}
+
+void Deadband::setThreshold(uint8_t channel, int32_t threshold)
+{
+  if (channel < AQW_CHANNEL_COUNT)
+    this->threshold[channel] = threshold;
+}
+
+void Deadband::setHeartbeat(uint32_t heartbeat_ms)
+{
+  this->heartbeat = heartbeat_ms;
+}
+
+void Deadband::reset()
+{
+  this->reported = false;
+  this->reported_at = 0;
+  this->present = 0;
+}
+
+bool Deadband::check(uint32_t now, const AirQualityWingData_t *p_data)
+{
+  int32_t values[AQW_CHANNEL_COUNT];
+  uint8_t present = 0;
+  bool changed = !this->reported;
+
+  for (uint8_t i = 0; i < AQW_CHANNEL_COUNT; i++)
+  {
+    if (aqw_channel_get(p_data, i, &values[i]))
+      present |= 1 << i;
+  }
+
+  // Something appearing or dropping out is always news
+  if (present != this->present)
+    changed = true;
+
+  for (uint8_t i = 0; i < AQW_CHANNEL_COUNT && !changed; i++)
+  {
+    if ((present & (1 << i)) == 0 || this->threshold[i] == DEADBAND_IGNORE)
+      continue;
+
+    if (this->threshold[i] == 0 || labs((long)values[i] - this->value[i]) >= this->threshold[i])
+      changed = true;
+  }
+
+  bool heartbeat = !changed && this->heartbeat > 0 && now - this->reported_at >= this->heartbeat;
+
+  if (!changed && !heartbeat)
+  {
+    this->stats.suppressed++;
+    return false;
+  }
+
+  if (heartbeat)
+    this->stats.heartbeats++;
+
+  this->stats.emitted++;
+  this->reported = true;
+  this->reported_at = now;
+  this->present = present;
+  memcpy(this->value, values, sizeof(values));
+
+  return true;
+}
+
+deadband_stats_t Deadband::getStats(bool reset)
+{
+  deadband_stats_t stats = this->stats;
+
+  if (reset)
+    memset(&this->stats, 0, sizeof(this->stats));
+
+  return stats;
+}
+
+void Deadband::getState(deadband_state_t *p_state)
+{
+  p_state->reported = this->reported;
+  p_state->present = this->present;
+  p_state->reported_at = this->reported_at;
+  memcpy(p_state->value, this->value, sizeof(this->value));
+}
+
+void Deadband::setState(const deadband_state_t *p_state)
+{
+  this->reported = p_state->reported;
+  this->present = p_state->present;
+  this->reported_at = p_state->reported_at;
+  memcpy(this->value, p_state->value, sizeof(this->value));
+}
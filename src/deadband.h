@@ -0,0 +1,71 @@
+/*
+ * Project Particle Squared
+ * Description: Report by exception filter for completed readings
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef DEADBAND_H
+#define DEADBAND_H
+
+#include "aqw_data.h"
+
+// Threshold that never triggers a report on its own
+#define DEADBAND_IGNORE INT32_MAX
+
+typedef struct
+{
+  uint32_t emitted;    // Includes heartbeats
+  uint32_t suppressed;
+  uint32_t heartbeats; // Emitted only because the heartbeat expired
+} deadband_stats_t;
+
+// The last report, for keeping it across a reset
+typedef struct
+{
+  bool reported;
+  uint8_t present;
+  uint32_t reported_at; // millis()
+  int32_t value[AQW_CHANNEL_COUNT];
+} deadband_state_t;
+
+class Deadband
+{
+public:
+  Deadband(void);
+
+  // Thresholds are in the library's fixed point units (centi-°C, centi-%RH,
+  // µg/m³, index points). 0 reports every reading of that channel.
+  void setThreshold(uint8_t channel, int32_t threshold);
+
+  // Longest time in ms between reports. 0 never forces one.
+  void setHeartbeat(uint32_t heartbeat_ms);
+
+  // Forgets the last report so the next reading goes out
+  void reset();
+
+  // True if `p_data` should be reported: a channel moved by at least its
+  // threshold since the last report, a channel appeared or went away,
+  // or the heartbeat expired.
+  bool check(uint32_t now, const AirQualityWingData_t *p_data);
+
+  deadband_stats_t getStats(bool reset = false);
+
+  void getState(deadband_state_t *p_state);
+  void setState(const deadband_state_t *p_state);
+
+private:
+  int32_t threshold[AQW_CHANNEL_COUNT];
+  uint32_t heartbeat;
+
+  // Values as of the last report
+  bool reported;
+  uint32_t reported_at;
+  uint8_t present;
+  int32_t value[AQW_CHANNEL_COUNT];
+
+  deadband_stats_t stats;
+};
+
+#endif //DEADBAND_H
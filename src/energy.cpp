@@ -0,0 +1,233 @@
+/*
+ * Project Particle Squared
+ * Description: Per component on-time, charge estimates and an energy budget
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include <string.h>
+
+#include "energy.h"
+
+// µA * µs in a µAh
+#define ENERGY_US_PER_HOUR 3600000000.0f
+
+static const uint32_t energy_default_ua[ENERGY_COMPONENT_COUNT] = {
+    ENERGY_HPMA115_UA,
+    ENERGY_SGP40_UA,
+    ENERGY_SHTC3_UA,
+    ENERGY_I2C_UA,
+};
+
+EnergyMeter::EnergyMeter(energy_clock_t clock) : clock(clock), budget(0), max_interval(0), soc(-1), min_soc(0)
+{
+  memcpy(this->current, energy_default_ua, sizeof(this->current));
+  memset(this->running, 0, sizeof(this->running));
+  memset(this->on_us, 0, sizeof(this->on_us));
+  memset(this->day_us, 0, sizeof(this->day_us));
+
+  this->report_start = 0;
+  this->day_start = 0;
+  this->day_cycles = 0;
+}
+
+void EnergyMeter::setClock(energy_clock_t clock)
+{
+  this->clock = clock;
+
+  uint32_t now = clock != nullptr ? clock() : 0;
+  this->report_start = now;
+  this->day_start = now;
+}
+
+void EnergyMeter::setCurrent(uint8_t component, uint32_t current_ua)
+{
+  if (component < ENERGY_COMPONENT_COUNT)
+    this->current[component] = current_ua;
+}
+
+void EnergyMeter::start(uint8_t component)
+{
+  if (component >= ENERGY_COMPONENT_COUNT || this->clock == nullptr || this->running[component])
+    return;
+
+  this->running[component] = true;
+  this->started_at[component] = this->clock();
+}
+
+void EnergyMeter::stop(uint8_t component)
+{
+  if (component >= ENERGY_COMPONENT_COUNT || this->clock == nullptr || !this->running[component])
+    return;
+
+  this->running[component] = false;
+  this->accrue(component, (uint64_t)(this->clock() - this->started_at[component]) * 1000);
+}
+
+void EnergyMeter::add(uint8_t component, uint32_t on_us)
+{
+  if (component < ENERGY_COMPONENT_COUNT)
+    this->accrue(component, on_us);
+}
+
+void EnergyMeter::accrue(uint8_t component, uint64_t on_us)
+{
+  if (this->clock != nullptr)
+    this->rollDay(this->clock());
+
+  this->on_us[component] += on_us;
+  this->day_us[component] += on_us;
+}
+
+// Starts a new budget day once the current one is over
+void EnergyMeter::rollDay(uint32_t now)
+{
+  if (now - this->day_start < ENERGY_DAY_MS)
+    return;
+
+  this->day_start += (now - this->day_start) / ENERGY_DAY_MS * ENERGY_DAY_MS;
+  this->day_cycles = 0;
+  memset(this->day_us, 0, sizeof(this->day_us));
+}
+
+void EnergyMeter::cycle()
+{
+  if (this->clock != nullptr)
+    this->rollDay(this->clock());
+
+  this->day_cycles++;
+}
+
+float EnergyMeter::charge(uint8_t component, uint64_t on_us)
+{
+  return (float)on_us * this->current[component] / ENERGY_US_PER_HOUR;
+}
+
+energy_report_t EnergyMeter::getReport(bool reset)
+{
+  energy_report_t report;
+  uint32_t now = this->clock != nullptr ? this->clock() : this->report_start;
+
+  report.total_uah = 0;
+  report.window_ms = now - this->report_start;
+
+  for (uint8_t i = 0; i < ENERGY_COMPONENT_COUNT; i++)
+  {
+    uint64_t on_us = this->on_us[i];
+
+    // Still on, count it up to now
+    if (this->running[i])
+      on_us += (uint64_t)(now - this->started_at[i]) * 1000;
+
+    report.on_ms[i] = on_us / 1000;
+    report.charge_uah[i] = this->charge(i, on_us);
+    report.total_uah += report.charge_uah[i];
+  }
+
+  if (reset)
+  {
+    memset(this->on_us, 0, sizeof(this->on_us));
+    this->report_start = now;
+
+    // Running components carry on from here
+    for (uint8_t i = 0; i < ENERGY_COMPONENT_COUNT; i++)
+    {
+      if (this->running[i])
+      {
+        this->day_us[i] += (uint64_t)(now - this->started_at[i]) * 1000;
+        this->started_at[i] = now;
+      }
+    }
+  }
+
+  return report;
+}
+
+void EnergyMeter::setBudget(uint32_t daily_uah, uint32_t max_interval)
+{
+  this->budget = daily_uah;
+  this->max_interval = max_interval;
+}
+
+void EnergyMeter::setStateOfCharge(float soc, float min_soc)
+{
+  this->soc = soc;
+  this->min_soc = min_soc;
+}
+
+energy_plan_t EnergyMeter::plan(uint32_t interval)
+{
+  energy_plan_t plan = {interval, true};
+  uint32_t max = this->max_interval > interval ? this->max_interval : interval;
+
+  // Battery first
+  if (this->soc >= 0 && this->soc < this->min_soc)
+  {
+    plan.interval = max;
+    plan.hpma115 = false;
+    return plan;
+  }
+
+  if (this->budget == 0 || this->clock == nullptr)
+    return plan;
+
+  uint32_t now = this->clock();
+  this->rollDay(now);
+
+  uint32_t elapsed = now - this->day_start;
+  uint32_t remaining = ENERGY_DAY_MS - elapsed;
+
+  // Split today's use into what scales with the interval and what doesn't
+  float used = 0, per_cycle = 0;
+  for (uint8_t i = 0; i < ENERGY_COMPONENT_COUNT; i++)
+  {
+    uint64_t on_us = this->day_us[i];
+
+    if (this->running[i])
+      on_us += (uint64_t)(now - this->started_at[i]) * 1000;
+
+    float uah = this->charge(i, on_us);
+    used += uah;
+
+    if (i != ENERGY_SGP40)
+      per_cycle += uah;
+  }
+
+  // Nothing to go on yet
+  if (this->day_cycles == 0 || elapsed == 0)
+    return plan;
+
+  per_cycle /= this->day_cycles;
+  float fixed = this->charge(ENERGY_SGP40, this->day_us[ENERGY_SGP40]) / elapsed * remaining;
+  float left = (float)this->budget - used - fixed;
+
+  // Can't afford another cycle with the HPMA115 at all
+  if (per_cycle > 0 && left < per_cycle)
+  {
+    plan.interval = max;
+    plan.hpma115 = false;
+    return plan;
+  }
+
+  if (per_cycle <= 0)
+    return plan;
+
+  // Spread what's left over the rest of the day
+  float needed = remaining / (left / per_cycle);
+
+  if (needed > interval)
+  {
+    if (needed > max)
+    {
+      plan.interval = max;
+      plan.hpma115 = false;
+    }
+    else
+    {
+      plan.interval = (uint32_t)needed;
+    }
+  }
+
+  return plan;
+}
@@ -0,0 +1,113 @@
+/*
+ * Project Particle Squared
+ * Description: Per component on-time, charge estimates and an energy budget
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Components
+enum
+{
+  ENERGY_HPMA115, // Fan and laser, enable() to disable()
+  ENERGY_SGP40,   // Heater, during each measurement
+  ENERGY_SHTC3,   // Measuring
+  ENERGY_I2C,     // Bus transfers
+  ENERGY_COMPONENT_COUNT,
+};
+
+// Typical active currents in µA, from the datasheets
+#define ENERGY_HPMA115_UA 80000
+#define ENERGY_SGP40_UA 3300
+#define ENERGY_SHTC3_UA 430
+#define ENERGY_I2C_UA 500
+
+// Budget period
+#define ENERGY_DAY_MS (24UL * 60 * 60 * 1000)
+
+// Default cap when stretching the interval
+#define ENERGY_MAX_INTERVAL_MS (60UL * 60 * 1000)
+
+// Millisecond clock. millis() on device, anything on the host.
+typedef uint32_t (*energy_clock_t)(void);
+
+typedef struct
+{
+  uint32_t on_ms[ENERGY_COMPONENT_COUNT];
+  float charge_uah[ENERGY_COMPONENT_COUNT];
+  float total_uah;
+  uint32_t window_ms; // Time covered
+} energy_report_t;
+
+typedef struct
+{
+  uint32_t interval; // Measurement interval to use
+  bool hpma115;      // False if the HPMA115 should stay off
+} energy_plan_t;
+
+class EnergyMeter
+{
+public:
+  EnergyMeter(energy_clock_t clock = nullptr);
+
+  void setClock(energy_clock_t clock);
+  void setCurrent(uint8_t component, uint32_t current_ua);
+
+  // Brackets a component's on-time. Repeated calls are ignored.
+  void start(uint8_t component);
+  void stop(uint8_t component);
+
+  // On-time measured elsewhere
+  void add(uint8_t component, uint32_t on_us);
+
+  // Marks a completed measurement cycle, used to cost one
+  void cycle();
+
+  // On-time and charge since the last reset
+  energy_report_t getReport(bool reset = false);
+
+  // Daily charge budget in µAh, 0 for none. Intervals never stretch past `max_interval`.
+  void setBudget(uint32_t daily_uah, uint32_t max_interval);
+  uint32_t getMaxInterval() { return this->max_interval; }
+
+  // Battery state of charge in %. Below `min_soc` the HPMA115 is turned off
+  // and the interval goes to the maximum. Negative `soc` if unknown.
+  void setStateOfCharge(float soc, float min_soc);
+
+  // Interval and HPMA115 state that keep the rest of the day in budget,
+  // given the interval that would otherwise be used.
+  energy_plan_t plan(uint32_t interval);
+
+private:
+  void accrue(uint8_t component, uint64_t on_us);
+  void rollDay(uint32_t now);
+  float charge(uint8_t component, uint64_t on_us);
+
+  energy_clock_t clock;
+  uint32_t current[ENERGY_COMPONENT_COUNT];
+
+  bool running[ENERGY_COMPONENT_COUNT];
+  uint32_t started_at[ENERGY_COMPONENT_COUNT];
+
+  // Since the last report reset
+  uint64_t on_us[ENERGY_COMPONENT_COUNT];
+  uint32_t report_start;
+
+  // Since the start of the budget day
+  uint64_t day_us[ENERGY_COMPONENT_COUNT];
+  uint32_t day_start;
+  uint32_t day_cycles;
+
+  uint32_t budget;
+  uint32_t max_interval;
+  float soc;
+  float min_soc;
+};
+
+#endif //ENERGY_H
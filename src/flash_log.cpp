@@ -0,0 +1,762 @@
+/*
+ * Project Particle Squared
+ * Description: Append only store and forward log of readings on LittleFS
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "flash_log.h"
+#include "crc32.h"
+
+FlashLog::FlashLog(void) : dir(FLASH_LOG_DIR), open(false), fd(-1), page_len(0), index_count(0), has_block(false),
+                           indexing(false), drain_batch(FLASH_LOG_DRAIN_BATCH), drain_interval(FLASH_LOG_DRAIN_INTERVAL_MS),
+                           trimmed(0), busy(0)
+{
+  memset(&this->stats, 0, sizeof(this->stats));
+}
+
+void FlashLog::path(uint32_t segment, char *p_path)
+{
+  snprintf(p_path, FLASH_LOG_PATH_SIZE, "%s/%08lx.log", this->dir, (unsigned long)segment);
+}
+
+bool FlashLog::readSegmentHeader(uint32_t segment, log_segment_t *p_header)
+{
+  char name[FLASH_LOG_PATH_SIZE];
+  uint8_t buf[LOG_SEGMENT_HEADER_SIZE];
+
+  this->path(segment, name);
+
+  int rfd = ::open(name, O_RDONLY);
+  if (rfd < 0)
+    return false;
+
+  int n = read(rfd, buf, sizeof(buf));
+  close(rfd);
+
+  return n == sizeof(buf) && log_segment_decode(buf, n, p_header) == LOG_SUCCESS;
+}
+
+bool FlashLog::readMeta(flash_log_meta_t *p_meta)
+{
+  char name[FLASH_LOG_PATH_SIZE];
+  snprintf(name, sizeof(name), "%s/meta", this->dir);
+
+  int rfd = ::open(name, O_RDONLY);
+  if (rfd < 0)
+    return false;
+
+  int n = read(rfd, p_meta, sizeof(flash_log_meta_t));
+  close(rfd);
+
+  return n == sizeof(flash_log_meta_t) && p_meta->magic == FLASH_LOG_META_MAGIC &&
+         p_meta->crc == crc32((const uint8_t *)p_meta, offsetof(flash_log_meta_t, crc));
+}
+
+// Written to the side then renamed over, so it's always either old or new
+uint32_t FlashLog::writeMeta()
+{
+  char name[FLASH_LOG_PATH_SIZE], tmp[FLASH_LOG_PATH_SIZE];
+  snprintf(name, sizeof(name), "%s/meta", this->dir);
+  snprintf(tmp, sizeof(tmp), "%s/meta.tmp", this->dir);
+
+  flash_log_meta_t meta;
+  meta.magic = FLASH_LOG_META_MAGIC;
+  meta.first_segment = this->first_segment;
+  meta.last_segment = this->last_segment;
+  meta.acked_seq = this->acked_seq;
+  meta.crc = crc32((const uint8_t *)&meta, offsetof(flash_log_meta_t, crc));
+
+  int wfd = ::open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (wfd < 0)
+    return FLASH_LOG_IO_ERROR;
+
+  bool ok = write(wfd, &meta, sizeof(meta)) == sizeof(meta) && fsync(wfd) == 0;
+  close(wfd);
+
+  if (!ok || rename(tmp, name) != 0)
+    return FLASH_LOG_IO_ERROR;
+
+  return FLASH_LOG_SUCCESS;
+}
+
+// Starts a new, empty segment as the last one
+uint32_t FlashLog::openSegment(uint32_t segment)
+{
+  char name[FLASH_LOG_PATH_SIZE];
+  uint8_t buf[LOG_SEGMENT_HEADER_SIZE];
+  log_segment_t header = {segment, this->next_seq};
+
+  this->path(segment, name);
+
+  if (this->fd >= 0)
+    close(this->fd);
+
+  this->fd = ::open(name, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (this->fd < 0)
+    return FLASH_LOG_IO_ERROR;
+
+  log_segment_encode(&header, buf, sizeof(buf));
+
+  if (write(this->fd, buf, sizeof(buf)) != sizeof(buf) || fsync(this->fd) != 0)
+    return FLASH_LOG_IO_ERROR;
+
+  this->last_segment = segment;
+  this->segment_size = sizeof(buf);
+
+  return FLASH_LOG_SUCCESS;
+}
+
+// Walks the records of `segment`, whose first is `first_seq`, up to the
+// first bad or incomplete one. `p_end` gets its offset, `p_last_seq` the
+// last good record's sequence number. Index blocks are rebuilt if `index`.
+uint32_t FlashLog::scanSegment(uint32_t segment, uint32_t first_seq, bool index, uint32_t *p_end, uint32_t *p_last_seq)
+{
+  char name[FLASH_LOG_PATH_SIZE];
+
+  this->path(segment, name);
+
+  int rfd = ::open(name, O_RDONLY);
+  if (rfd < 0)
+    return FLASH_LOG_IO_ERROR;
+
+  uint32_t last_seq = first_seq - 1;
+  uint32_t end = LOG_SEGMENT_HEADER_SIZE;
+  size_t carry = 0;
+
+  // Page buffer is empty at this point, use it for the scan
+  lseek(rfd, LOG_SEGMENT_HEADER_SIZE, SEEK_SET);
+
+  while (true)
+  {
+    int n = read(rfd, &this->page[carry], sizeof(this->page) - carry);
+    if (n <= 0)
+      break;
+
+    size_t total = carry + n;
+    size_t pos = 0, used;
+    log_record_t record;
+
+    while (log_record_decode(&this->page[pos], total - pos, &record, &used) == LOG_SUCCESS)
+    {
+      if (index)
+        this->indexRecord(segment, end, record.timestamp);
+
+      last_seq = record.seq;
+      end += used;
+      pos += used;
+    }
+
+    carry = total - pos;
+    memmove(this->page, &this->page[pos], carry);
+
+    // A full buffer that doesn't parse is corruption, not a short read
+    if (carry == sizeof(this->page))
+      break;
+  }
+
+  close(rfd);
+
+  *p_end = end;
+  *p_last_seq = last_seq;
+
+  return FLASH_LOG_SUCCESS;
+}
+
+// Finds the end of the last segment and cuts off a torn write, if any.
+// Only this segment is read, everything before it was complete when it rolled.
+uint32_t FlashLog::recoverTail()
+{
+  char name[FLASH_LOG_PATH_SIZE];
+  log_segment_t header;
+  uint32_t end, last_seq, err_code;
+
+  // Torn while it was being opened. The sequence carries on from the
+  // segment before it, which may still hold unacknowledged records.
+  if (!this->readSegmentHeader(this->last_segment, &header))
+  {
+    if (this->last_segment == this->first_segment)
+    {
+      // Nothing older left, all of it was acknowledged
+      this->next_seq = this->acked_seq + 1;
+    }
+    else
+    {
+      if (!this->readSegmentHeader(this->last_segment - 1, &header))
+        return FLASH_LOG_IO_ERROR;
+
+      err_code = this->scanSegment(this->last_segment - 1, header.first_seq, false, &end, &last_seq);
+      if (err_code != FLASH_LOG_SUCCESS)
+        return err_code;
+
+      this->next_seq = last_seq + 1 > this->acked_seq + 1 ? last_seq + 1 : this->acked_seq + 1;
+    }
+
+    return this->openSegment(this->last_segment);
+  }
+
+  // Rebuilds this segment's index blocks on the way
+  err_code = this->scanSegment(this->last_segment, header.first_seq, true, &end, &last_seq);
+  if (err_code != FLASH_LOG_SUCCESS)
+    return err_code;
+
+  this->path(this->last_segment, name);
+
+  this->fd = ::open(name, O_WRONLY);
+  if (this->fd < 0)
+    return FLASH_LOG_IO_ERROR;
+
+  off_t size = lseek(this->fd, 0, SEEK_END);
+
+  if (size > (off_t)end)
+  {
+    Log.warn("flash log: dropping %lu torn bytes", (unsigned long)(size - end));
+    this->stats.recovered_bytes += size - end;
+
+    if (ftruncate(this->fd, end) != 0)
+      return FLASH_LOG_IO_ERROR;
+  }
+
+  lseek(this->fd, end, SEEK_SET);
+
+  this->next_seq = last_seq + 1;
+  this->segment_size = end;
+
+  return FLASH_LOG_SUCCESS;
+}
+
+uint32_t FlashLog::begin(const char *dir)
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+
+  flash_log_meta_t meta;
+  log_segment_t header;
+
+  this->end();
+  this->dir = dir;
+
+  // Already there is fine
+  mkdir(dir, 0777);
+
+  if (this->readMeta(&meta))
+  {
+    this->first_segment = meta.first_segment;
+    this->last_segment = meta.last_segment;
+    this->acked_seq = meta.acked_seq;
+  }
+  else
+  {
+    this->first_segment = 0;
+    this->last_segment = 0;
+    this->acked_seq = 0;
+  }
+
+  // Meta is written after a roll and before deleting, so it can trail by a segment
+  while (this->readSegmentHeader(this->last_segment + 1, &header))
+    this->last_segment++;
+
+  while (this->first_segment < this->last_segment && !this->readSegmentHeader(this->first_segment, &header))
+    this->first_segment++;
+
+  // Index of the closed segments, the last one is rebuilt by the tail scan
+  this->indexing = false;
+  this->loadIndex();
+
+  uint32_t err_code = this->recoverTail();
+  if (err_code != FLASH_LOG_SUCCESS)
+  {
+    Log.error("flash log: recovery failed");
+    return err_code;
+  }
+
+  // Compact while at it
+  this->trimmed = this->first_segment;
+  this->writeIndex();
+  this->indexing = true;
+
+  this->page_len = 0;
+  this->open = true;
+  this->rewind();
+  this->last_drain = millis() - this->drain_interval;
+
+  Log.info("flash log: segments %lu-%lu next seq %lu pending %lu", (unsigned long)this->first_segment,
+           (unsigned long)this->last_segment, (unsigned long)this->next_seq, (unsigned long)this->pending());
+
+  return this->writeMeta();
+}
+
+void FlashLog::end()
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+
+  if (this->open)
+    this->flush();
+
+  if (this->fd >= 0)
+    close(this->fd);
+
+  this->fd = -1;
+  this->open = false;
+}
+
+uint32_t FlashLog::append(uint32_t timestamp, const AirQualityWingData_t *p_data)
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+
+  uint8_t record[LOG_RECORD_MAX_SIZE];
+  uint32_t err_code;
+
+  if (!this->open)
+    return FLASH_LOG_NOT_OPEN;
+
+  size_t len = log_record_encode(this->next_seq, timestamp, p_data, record, sizeof(record));
+
+  // Page full
+  if (this->page_len + len > sizeof(this->page))
+  {
+    err_code = this->flush();
+    if (err_code != FLASH_LOG_SUCCESS)
+      return err_code;
+  }
+
+  // Segment full
+  if (this->segment_size + this->page_len + len > FLASH_LOG_SEGMENT_SIZE)
+  {
+    err_code = this->flush();
+    if (err_code == FLASH_LOG_SUCCESS)
+      err_code = this->roll();
+    if (err_code != FLASH_LOG_SUCCESS)
+      return err_code;
+  }
+
+  this->indexRecord(this->last_segment, this->segment_size + this->page_len, timestamp);
+
+  memcpy(&this->page[this->page_len], record, len);
+  this->page_len += len;
+  this->next_seq++;
+  this->stats.appended++;
+
+  return FLASH_LOG_SUCCESS;
+}
+
+uint32_t FlashLog::flush()
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+
+  if (!this->open)
+    return FLASH_LOG_NOT_OPEN;
+
+  if (this->page_len == 0)
+    return FLASH_LOG_SUCCESS;
+
+  if (write(this->fd, this->page, this->page_len) != (ssize_t)this->page_len || fsync(this->fd) != 0)
+  {
+    Log.error("flash log: write failed");
+    return FLASH_LOG_IO_ERROR;
+  }
+
+  this->segment_size += this->page_len;
+  this->page_len = 0;
+  this->stats.pages_written++;
+
+  return FLASH_LOG_SUCCESS;
+}
+
+// Moves on to a new segment, dropping the oldest if the log is full
+uint32_t FlashLog::roll()
+{
+  uint32_t err_code = this->openSegment(this->last_segment + 1);
+  if (err_code != FLASH_LOG_SUCCESS)
+    return err_code;
+
+  if (this->last_segment - this->first_segment + 1 > FLASH_LOG_MAX_SEGMENTS)
+  {
+    log_segment_t header;
+
+    this->first_segment++;
+
+    // Whatever was in it is gone
+    if (this->readSegmentHeader(this->first_segment, &header) && header.first_seq - 1 > this->acked_seq)
+    {
+      Log.warn("flash log: full, dropped seq %lu-%lu", (unsigned long)this->acked_seq + 1, (unsigned long)header.first_seq - 1);
+      this->acked_seq = header.first_seq - 1;
+      this->stats.dropped_segments++;
+    }
+
+    if (this->read_segment < this->first_segment)
+    {
+      this->read_segment = this->first_segment;
+      this->read_offset = LOG_SEGMENT_HEADER_SIZE;
+    }
+
+    err_code = this->writeMeta();
+    this->trim();
+
+    return err_code;
+  }
+
+  return this->writeMeta();
+}
+
+// Deletes the segments that dropped out of the log, once nothing reads them
+void FlashLog::trim()
+{
+  if (this->busy > 0 || this->trimmed >= this->first_segment)
+    return;
+
+  for (uint32_t segment = this->trimmed; segment < this->first_segment; segment++)
+  {
+    char name[FLASH_LOG_PATH_SIZE];
+    this->path(segment, name);
+    unlink(name);
+  }
+
+  this->trimmed = this->first_segment;
+
+  this->pruneIndex();
+  this->writeIndex();
+}
+
+void FlashLog::setDrainRate(uint16_t batch, uint32_t interval_ms)
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  this->drain_batch = batch;
+  this->drain_interval = interval_ms;
+}
+
+uint16_t FlashLog::drain(uint32_t now, flash_log_send_cb send, void *p_context)
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+
+  uint8_t buf[LOG_RECORD_MAX_SIZE];
+  char name[FLASH_LOG_PATH_SIZE];
+  log_record_t record;
+  size_t used;
+  uint16_t sent = 0;
+  int rfd = -1;
+
+  if (!this->open || now - this->last_drain < this->drain_interval)
+    return 0;
+
+  this->last_drain = now;
+
+  // Make everything so far readable
+  if (this->flush() != FLASH_LOG_SUCCESS)
+    return 0;
+
+  this->busy++;
+
+  while (sent < this->drain_batch && this->read_segment <= this->last_segment)
+  {
+    if (rfd < 0)
+    {
+      this->path(this->read_segment, name);
+
+      rfd = ::open(name, O_RDONLY);
+      if (rfd < 0)
+        break;
+    }
+
+    lseek(rfd, this->read_offset, SEEK_SET);
+    int n = read(rfd, buf, sizeof(buf));
+
+    // End of this segment, on to the next if there is one
+    if (n <= 0 || log_record_decode(buf, n, &record, &used) != LOG_SUCCESS)
+    {
+      if (this->read_segment == this->last_segment)
+        break;
+
+      close(rfd);
+      rfd = -1;
+      this->read_segment++;
+      this->read_offset = LOG_SEGMENT_HEADER_SIZE;
+      continue;
+    }
+
+    if (record.seq > this->sent_seq)
+    {
+      uint32_t segment = this->read_segment, offset = this->read_offset;
+
+      if (!send(buf, used, &record, p_context))
+        break;
+
+      this->sent_seq = record.seq;
+      this->stats.sent++;
+      sent++;
+
+      // An ack() or rewind() from send() moved the cursor, pick it up there
+      if (this->read_segment != segment || this->read_offset != offset)
+      {
+        close(rfd);
+        rfd = -1;
+        continue;
+      }
+    }
+
+    this->read_offset += used;
+  }
+
+  if (rfd >= 0)
+    close(rfd);
+
+  this->busy--;
+  this->trim();
+
+  return sent;
+}
+
+uint32_t FlashLog::ack(uint32_t seq)
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+
+  log_segment_t header;
+
+  if (!this->open)
+    return FLASH_LOG_NOT_OPEN;
+
+  if (seq >= this->next_seq)
+    seq = this->next_seq - 1;
+
+  if (seq <= this->acked_seq)
+    return FLASH_LOG_SUCCESS;
+
+  this->acked_seq = seq;
+
+  // A segment is done once the next one starts at or before the first unacked record
+  uint32_t first = this->first_segment;
+  while (first < this->last_segment && this->readSegmentHeader(first + 1, &header) && header.first_seq <= seq + 1)
+    first++;
+
+  this->first_segment = first;
+
+  if (this->read_segment < first)
+  {
+    this->read_segment = first;
+    this->read_offset = LOG_SEGMENT_HEADER_SIZE;
+  }
+
+  // Meta first so a reset never points at a deleted segment
+  uint32_t err_code = this->writeMeta();
+  this->trim();
+
+  return err_code;
+}
+
+// Extends the open block, or closes it if the record starts in a new one
+void FlashLog::indexRecord(uint32_t segment, uint32_t offset, uint32_t timestamp)
+{
+  if (!this->has_block || this->block.segment != segment ||
+      this->block.offset / FLASH_LOG_BLOCK_SIZE != offset / FLASH_LOG_BLOCK_SIZE)
+  {
+    if (this->has_block)
+      this->closeBlock();
+
+    this->block = {segment, offset, UINT32_MAX, 0};
+    this->has_block = true;
+  }
+
+  if (timestamp == 0)
+    return;
+
+  if (timestamp < this->block.min_ts)
+    this->block.min_ts = timestamp;
+  if (timestamp > this->block.max_ts)
+    this->block.max_ts = timestamp;
+}
+
+void FlashLog::closeBlock()
+{
+  // Can only overflow if the geometry changed, oldest goes
+  if (this->index_count == FLASH_LOG_INDEX_SIZE)
+  {
+    memmove(this->index, &this->index[1], sizeof(flash_log_block_t) * (FLASH_LOG_INDEX_SIZE - 1));
+    this->index_count--;
+  }
+
+  this->index[this->index_count++] = this->block;
+
+  if (!this->indexing)
+    return;
+
+  char name[FLASH_LOG_PATH_SIZE];
+  snprintf(name, sizeof(name), "%s/index", this->dir);
+
+  int wfd = ::open(name, O_WRONLY | O_CREAT | O_APPEND, 0666);
+  if (wfd < 0)
+    return;
+
+  write(wfd, &this->block, sizeof(this->block));
+  close(wfd);
+}
+
+// Keeps the entries of closed segments that still exist
+void FlashLog::loadIndex()
+{
+  char name[FLASH_LOG_PATH_SIZE];
+  flash_log_block_t entry;
+
+  this->index_count = 0;
+  this->has_block = false;
+
+  snprintf(name, sizeof(name), "%s/index", this->dir);
+
+  int rfd = ::open(name, O_RDONLY);
+  if (rfd < 0)
+    return;
+
+  while (read(rfd, &entry, sizeof(entry)) == sizeof(entry))
+  {
+    if (entry.segment < this->first_segment || entry.segment >= this->last_segment)
+      continue;
+
+    if (this->index_count == FLASH_LOG_INDEX_SIZE)
+      break;
+
+    this->index[this->index_count++] = entry;
+  }
+
+  close(rfd);
+}
+
+// Rewrites the index file from the cache
+uint32_t FlashLog::writeIndex()
+{
+  char name[FLASH_LOG_PATH_SIZE], tmp[FLASH_LOG_PATH_SIZE];
+  snprintf(name, sizeof(name), "%s/index", this->dir);
+  snprintf(tmp, sizeof(tmp), "%s/index.tmp", this->dir);
+
+  int wfd = ::open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (wfd < 0)
+    return FLASH_LOG_IO_ERROR;
+
+  ssize_t size = sizeof(flash_log_block_t) * this->index_count;
+  bool ok = write(wfd, this->index, size) == size;
+  close(wfd);
+
+  if (!ok || rename(tmp, name) != 0)
+    return FLASH_LOG_IO_ERROR;
+
+  return FLASH_LOG_SUCCESS;
+}
+
+// Drops the entries of deleted segments
+void FlashLog::pruneIndex()
+{
+  uint16_t keep = 0;
+
+  for (uint16_t i = 0; i < this->index_count; i++)
+  {
+    if (this->index[i].segment >= this->first_segment)
+      this->index[keep++] = this->index[i];
+  }
+
+  this->index_count = keep;
+}
+
+// False if the callback asked to stop
+bool FlashLog::queryBlock(const flash_log_block_t *p_block, uint32_t from, uint32_t to, log_record_cb callback, void *p_context,
+                          uint32_t *p_count)
+{
+  uint8_t buf[LOG_RECORD_MAX_SIZE];
+  char name[FLASH_LOG_PATH_SIZE];
+  log_record_t record;
+  size_t used;
+  bool more = true;
+
+  this->path(p_block->segment, name);
+
+  int rfd = ::open(name, O_RDONLY);
+  if (rfd < 0)
+    return true;
+
+  uint32_t offset = p_block->offset;
+
+  // Records starting in this block, one at a time
+  while (offset / FLASH_LOG_BLOCK_SIZE == p_block->offset / FLASH_LOG_BLOCK_SIZE)
+  {
+    lseek(rfd, offset, SEEK_SET);
+    int n = read(rfd, buf, sizeof(buf));
+
+    if (n <= 0 || log_record_decode(buf, n, &record, &used) != LOG_SUCCESS)
+      break;
+
+    offset += used;
+
+    if (record.timestamp < from || record.timestamp > to)
+      continue;
+
+    (*p_count)++;
+
+    if (!callback(&record, p_context))
+    {
+      more = false;
+      break;
+    }
+  }
+
+  close(rfd);
+
+  return more;
+}
+
+uint32_t FlashLog::query(uint32_t from, uint32_t to, log_record_cb callback, void *p_context)
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+
+  uint32_t count = 0;
+
+  if (!this->open || this->flush() != FLASH_LOG_SUCCESS)
+    return 0;
+
+  this->busy++;
+
+  for (uint16_t i = 0; i <= this->index_count; i++)
+  {
+    // Open block last
+    const flash_log_block_t *p_block = i < this->index_count ? &this->index[i] : &this->block;
+
+    if (i == this->index_count && !this->has_block)
+      break;
+
+    if (p_block->max_ts < from || p_block->min_ts > to)
+      continue;
+
+    if (!this->queryBlock(p_block, from, to, callback, p_context, &count))
+      break;
+  }
+
+  this->busy--;
+  this->trim();
+
+  return count;
+}
+
+void FlashLog::rewind()
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  this->read_segment = this->first_segment;
+  this->read_offset = LOG_SEGMENT_HEADER_SIZE;
+  this->sent_seq = this->acked_seq;
+}
+
+uint32_t FlashLog::pending()
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  return this->next_seq - 1 - this->acked_seq;
+}
+
+flash_log_stats_t FlashLog::getStats(bool reset)
+{
+  std::lock_guard<std::recursive_mutex> lock(this->mutex);
+  flash_log_stats_t stats = this->stats;
+
+  if (reset)
+    memset(&this->stats, 0, sizeof(this->stats));
+
+  return stats;
+}
@@ -0,0 +1,193 @@
+/*
+ * Project Particle Squared
+ * Description: Append only store and forward log of readings on LittleFS
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include <mutex>
+
+#include "application.h"
+#include "log_format.h"
+
+// Layout on the filesystem. Segments are `<dir>/<id in hex>.log`, see log_format.h.
+#ifndef FLASH_LOG_DIR
+#define FLASH_LOG_DIR "/aqw"
+#endif
+#define FLASH_LOG_PATH_SIZE 32
+
+// Records are batched into pages before they're written
+#ifndef FLASH_LOG_PAGE_SIZE
+#define FLASH_LOG_PAGE_SIZE 512
+#endif
+
+// Oldest segment is dropped when the log holds this many
+#ifndef FLASH_LOG_SEGMENT_SIZE
+#define FLASH_LOG_SEGMENT_SIZE (16 * 1024)
+#endif
+#ifndef FLASH_LOG_MAX_SEGMENTS
+#define FLASH_LOG_MAX_SEGMENTS 16
+#endif
+
+// Time index granularity. Each block of a segment gets the min and max
+// timestamp of its records, kept in `<dir>/index` and cached in RAM.
+#ifndef FLASH_LOG_BLOCK_SIZE
+#define FLASH_LOG_BLOCK_SIZE 4096
+#endif
+#define FLASH_LOG_INDEX_SIZE (FLASH_LOG_MAX_SEGMENTS * (FLASH_LOG_SEGMENT_SIZE / FLASH_LOG_BLOCK_SIZE))
+
+// Drain pacing defaults
+#define FLASH_LOG_DRAIN_BATCH 4
+#define FLASH_LOG_DRAIN_INTERVAL_MS 1000
+
+#define FLASH_LOG_META_MAGIC 0x4d575141 // "AQWM"
+
+// Error codes
+#define FLASH_LOG_SUCCESS 0
+#define FLASH_LOG_IO_ERROR 1
+#define FLASH_LOG_NOT_OPEN 2
+
+// Gets each record drained, raw as stored and decoded. Return false if it
+// couldn't be sent (e.g. offline), it's offered again on the next drain().
+typedef bool (*flash_log_send_cb)(const uint8_t *p_raw, size_t len, const log_record_t *p_record, void *p_context);
+
+// Recovery hint, rewritten on segment roll and on ack()
+typedef struct
+{
+  uint32_t magic;
+  uint32_t first_segment;
+  uint32_t last_segment;
+  uint32_t acked_seq;
+  uint32_t crc;
+} flash_log_meta_t;
+
+// Index entry. Records with a timestamp of 0 don't count towards the range.
+typedef struct
+{
+  uint32_t segment;
+  uint32_t offset; // First record of the block
+  uint32_t min_ts;
+  uint32_t max_ts;
+} flash_log_block_t;
+
+typedef struct
+{
+  uint32_t appended;
+  uint32_t sent;
+  uint32_t dropped_segments; // Dropped unacknowledged because the log was full
+  uint32_t pages_written;
+  uint32_t recovered_bytes; // Torn tail cut off by begin()
+} flash_log_stats_t;
+
+// Safe to share between threads, e.g. the worker appending while loop()
+// drains. Callbacks may call back in, an ack() from send() included.
+class FlashLog
+{
+public:
+  FlashLog(void);
+
+  // Opens the log in `dir`, creating it if needed. Recovers from the meta
+  // hint and a scan of the last segment only.
+  uint32_t begin(const char *dir = FLASH_LOG_DIR);
+  void end();
+
+  // Buffers one reading. Full pages are written out as they fill.
+  uint32_t append(uint32_t timestamp, const AirQualityWingData_t *p_data);
+
+  // Writes out a partial page
+  uint32_t flush();
+
+  // Paces drain() to at most `batch` records every `interval_ms`
+  void setDrainRate(uint16_t batch, uint32_t interval_ms);
+
+  // Offers unsent records to `send`, oldest first, within the drain rate.
+  // Returns how many were sent. They stay on flash until ack()'d.
+  uint16_t drain(uint32_t now, flash_log_send_cb send, void *p_context);
+
+  // Everything up to and including `seq` has been delivered.
+  // Segments that are fully delivered are deleted.
+  uint32_t ack(uint32_t seq);
+
+  // Sends everything that wasn't acknowledged again, e.g. after a lost connection
+  void rewind();
+
+  // Records not yet acknowledged
+  uint32_t pending();
+
+  // Streams the stored records timestamped within [from, to] to `callback`.
+  // Only blocks whose range overlaps are read, one record at a time.
+  // Returns the number of records delivered.
+  uint32_t query(uint32_t from, uint32_t to, log_record_cb callback, void *p_context);
+
+  // Sequence number the next append() gets
+  uint32_t nextSeq()
+  {
+    std::lock_guard<std::recursive_mutex> lock(this->mutex);
+    return this->next_seq;
+  }
+
+  flash_log_stats_t getStats(bool reset = false);
+
+private:
+  void path(uint32_t segment, char *p_path);
+  bool readSegmentHeader(uint32_t segment, log_segment_t *p_header);
+  uint32_t openSegment(uint32_t segment);
+  uint32_t scanSegment(uint32_t segment, uint32_t first_seq, bool index, uint32_t *p_end, uint32_t *p_last_seq);
+  uint32_t recoverTail();
+  uint32_t roll();
+  void trim();
+  uint32_t writeMeta();
+  bool readMeta(flash_log_meta_t *p_meta);
+  void indexRecord(uint32_t segment, uint32_t offset, uint32_t timestamp);
+  void closeBlock();
+  void loadIndex();
+  uint32_t writeIndex();
+  void pruneIndex();
+  bool queryBlock(const flash_log_block_t *p_block, uint32_t from, uint32_t to, log_record_cb callback, void *p_context,
+                  uint32_t *p_count);
+
+  const char *dir;
+  bool open;
+  int fd; // Last segment, write only
+
+  uint32_t first_segment;
+  uint32_t last_segment;
+  uint32_t segment_size; // Bytes on flash in the last segment
+  uint32_t next_seq;
+  uint32_t acked_seq;
+
+  // Write batching
+  uint8_t page[FLASH_LOG_PAGE_SIZE];
+  size_t page_len;
+
+  // Time index, closed blocks plus the one being filled
+  flash_log_block_t index[FLASH_LOG_INDEX_SIZE];
+  uint16_t index_count;
+  flash_log_block_t block;
+  bool has_block;
+  bool indexing; // Closed blocks also go to the index file
+
+  // Drain cursor
+  uint32_t read_segment;
+  uint32_t read_offset;
+  uint32_t sent_seq;
+  uint16_t drain_batch;
+  uint32_t drain_interval;
+  uint32_t last_drain;
+
+  // Segments below `trimmed` are deleted. A drain() or query() in
+  // progress holds deletes back so it never loses the file it reads.
+  uint32_t trimmed;
+  uint8_t busy;
+
+  flash_log_stats_t stats;
+
+  // Recursive so callbacks can call back in
+  std::recursive_mutex mutex;
+};
+
+#endif //FLASH_LOG_H
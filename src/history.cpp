@@ -0,0 +1,303 @@
+/*
+ * Project Particle Squared
+ * Description: Tiered reading history kept in retained RAM
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include <string.h>
+
+#include "history.h"
+
+#if defined(PARTICLE)
+#include "application.h"
+#else
+#define retained // Plain RAM off device
+#endif
+
+#define HISTORY_MINUTE_S 60
+#define HISTORY_HOUR_S 3600
+
+// Survives resets and sleep
+retained static history_store_t history_store;
+
+static int16_t clamp16(int32_t value)
+{
+  if (value > INT16_MAX)
+    return INT16_MAX;
+  if (value < INT16_MIN)
+    return INT16_MIN;
+  return value;
+}
+
+static void accumulator_reset(history_accumulator_t *p_acc, uint32_t start)
+{
+  p_acc->start = start;
+
+  for (uint8_t i = 0; i < AQW_CHANNEL_COUNT; i++)
+  {
+    p_acc->sum[i] = 0;
+    p_acc->count[i] = 0;
+    p_acc->min[i] = INT16_MAX;
+    p_acc->max[i] = INT16_MIN;
+  }
+}
+
+// Moves a finished period into a rollup tier
+template <uint16_t N>
+static void rollup_push(history_rollup_tier_t<N> *p_tier, const history_accumulator_t *p_acc)
+{
+  uint16_t slot = (p_tier->head + p_tier->count) % N;
+
+  if (p_tier->count == N)
+    p_tier->head = (p_tier->head + 1) % N;
+  else
+    p_tier->count++;
+
+  p_tier->timestamp[slot] = p_acc->start;
+  p_tier->present[slot] = 0;
+
+  for (uint8_t i = 0; i < AQW_CHANNEL_COUNT; i++)
+  {
+    if (p_acc->count[i] == 0)
+      continue;
+
+    p_tier->present[slot] |= 1 << i;
+    p_tier->min[i][slot] = p_acc->min[i];
+    p_tier->max[i][slot] = p_acc->max[i];
+    p_tier->mean[i][slot] = p_acc->sum[i] / p_acc->count[i];
+  }
+}
+
+History::History(void) : store(&history_store) {}
+
+void History::begin()
+{
+  // Layout must match too, the depths are build options
+  if (this->store->magic != HISTORY_MAGIC || this->store->version != HISTORY_VERSION ||
+      this->store->size != sizeof(history_store_t))
+    this->clear();
+}
+
+void History::clear()
+{
+  memset(this->store, 0, sizeof(history_store_t));
+  accumulator_reset(&this->store->minute_acc, 0);
+  accumulator_reset(&this->store->hour_acc, 0);
+  this->store->magic = HISTORY_MAGIC;
+  this->store->version = HISTORY_VERSION;
+  this->store->size = sizeof(history_store_t);
+}
+
+void History::fold(history_accumulator_t *p_acc, uint8_t channel, int16_t min, int16_t max, int32_t sum, uint16_t count)
+{
+  if (min < p_acc->min[channel])
+    p_acc->min[channel] = min;
+  if (max > p_acc->max[channel])
+    p_acc->max[channel] = max;
+
+  p_acc->sum[channel] += sum;
+  p_acc->count[channel] += count;
+}
+
+void History::flushMinute()
+{
+  history_accumulator_t *p_acc = &this->store->minute_acc;
+
+  rollup_push(&this->store->minute, p_acc);
+
+  // Hour mean is weighted by samples, not minutes
+  for (uint8_t i = 0; i < AQW_CHANNEL_COUNT; i++)
+  {
+    if (p_acc->count[i] != 0)
+      this->fold(&this->store->hour_acc, i, p_acc->min[i], p_acc->max[i], p_acc->sum[i], p_acc->count[i]);
+  }
+}
+
+void History::flushHour()
+{
+  rollup_push(&this->store->hour, &this->store->hour_acc);
+}
+
+void History::add(uint32_t timestamp, const AirQualityWingData_t *p_data)
+{
+  history_store_t *p_store = this->store;
+
+  int32_t values[AQW_CHANNEL_COUNT];
+  uint8_t present = 0;
+
+  for (uint8_t i = 0; i < AQW_CHANNEL_COUNT; i++)
+  {
+    if (aqw_channel_get(p_data, i, &values[i]))
+      present |= 1 << i;
+  }
+
+  uint32_t minute = timestamp - timestamp % HISTORY_MINUTE_S;
+  uint32_t hour = timestamp - timestamp % HISTORY_HOUR_S;
+
+  // Close out periods this reading is past. At most one of each per add.
+  if (p_store->minute_acc.start != minute)
+  {
+    if (p_store->minute_acc.start != 0)
+      this->flushMinute();
+
+    accumulator_reset(&p_store->minute_acc, minute);
+  }
+
+  if (p_store->hour_acc.start != hour)
+  {
+    if (p_store->hour_acc.start != 0)
+      this->flushHour();
+
+    accumulator_reset(&p_store->hour_acc, hour);
+  }
+
+  // Full resolution ring
+  history_raw_tier_t<HISTORY_RAW_DEPTH> *p_raw = &p_store->raw;
+  uint16_t slot = (p_raw->head + p_raw->count) % HISTORY_RAW_DEPTH;
+
+  if (p_raw->count == HISTORY_RAW_DEPTH)
+    p_raw->head = (p_raw->head + 1) % HISTORY_RAW_DEPTH;
+  else
+    p_raw->count++;
+
+  p_raw->timestamp[slot] = timestamp;
+  p_raw->present[slot] = present;
+
+  for (uint8_t i = 0; i < AQW_CHANNEL_COUNT; i++)
+  {
+    int16_t value = clamp16(values[i]);
+    p_raw->value[i][slot] = value;
+
+    if (present & (1 << i))
+      this->fold(&p_store->minute_acc, i, value, value, value, 1);
+  }
+}
+
+// Shared scan over either tier type
+template <typename T>
+static uint16_t tier_scan(const T *p_tier, uint16_t depth, uint32_t from, uint32_t to,
+                          void (*fill)(const T *, uint16_t, history_entry_t *), history_cb callback, void *p_context)
+{
+  uint16_t visited = 0;
+  history_entry_t entry;
+
+  for (uint16_t n = 0; n < p_tier->count; n++)
+  {
+    uint16_t slot = (p_tier->head + n) % depth;
+    uint32_t timestamp = p_tier->timestamp[slot];
+
+    if (timestamp < from || timestamp > to)
+      continue;
+
+    fill(p_tier, slot, &entry);
+    callback(&entry, p_context);
+    visited++;
+  }
+
+  return visited;
+}
+
+static void fill_raw(const history_raw_tier_t<HISTORY_RAW_DEPTH> *p_tier, uint16_t slot, history_entry_t *p_entry)
+{
+  p_entry->timestamp = p_tier->timestamp[slot];
+  p_entry->present = p_tier->present[slot];
+
+  for (uint8_t i = 0; i < AQW_CHANNEL_COUNT; i++)
+    p_entry->min[i] = p_entry->mean[i] = p_entry->max[i] = p_tier->value[i][slot];
+}
+
+template <uint16_t N>
+static void fill_rollup(const history_rollup_tier_t<N> *p_tier, uint16_t slot, history_entry_t *p_entry)
+{
+  p_entry->timestamp = p_tier->timestamp[slot];
+  p_entry->present = p_tier->present[slot];
+
+  for (uint8_t i = 0; i < AQW_CHANNEL_COUNT; i++)
+  {
+    p_entry->min[i] = p_tier->min[i][slot];
+    p_entry->mean[i] = p_tier->mean[i][slot];
+    p_entry->max[i] = p_tier->max[i][slot];
+  }
+}
+
+uint16_t History::query(uint8_t tier, uint32_t from, uint32_t to, history_cb callback, void *p_context)
+{
+  switch (tier)
+  {
+  case HISTORY_RAW:
+    return tier_scan(&this->store->raw, HISTORY_RAW_DEPTH, from, to, fill_raw, callback, p_context);
+  case HISTORY_MINUTE:
+    return tier_scan(&this->store->minute, HISTORY_MINUTE_DEPTH, from, to, fill_rollup<HISTORY_MINUTE_DEPTH>, callback, p_context);
+  case HISTORY_HOUR:
+    return tier_scan(&this->store->hour, HISTORY_HOUR_DEPTH, from, to, fill_rollup<HISTORY_HOUR_DEPTH>, callback, p_context);
+  }
+
+  return 0;
+}
+
+// Walks one channel's arrays only
+template <typename T>
+static bool channel_stat(const T *p_tier, uint16_t depth, const int16_t *p_min, const int16_t *p_mean, const int16_t *p_max,
+                         uint8_t channel, uint32_t from, uint32_t to, history_stat_t *p_stat)
+{
+  int32_t sum = 0;
+
+  p_stat->min = INT16_MAX;
+  p_stat->max = INT16_MIN;
+  p_stat->count = 0;
+
+  for (uint16_t n = 0; n < p_tier->count; n++)
+  {
+    uint16_t slot = (p_tier->head + n) % depth;
+    uint32_t timestamp = p_tier->timestamp[slot];
+
+    if (timestamp < from || timestamp > to || (p_tier->present[slot] & (1 << channel)) == 0)
+      continue;
+
+    if (p_min[slot] < p_stat->min)
+      p_stat->min = p_min[slot];
+    if (p_max[slot] > p_stat->max)
+      p_stat->max = p_max[slot];
+
+    sum += p_mean[slot];
+    p_stat->count++;
+  }
+
+  if (p_stat->count == 0)
+    return false;
+
+  p_stat->mean = sum / p_stat->count;
+
+  return true;
+}
+
+bool History::aggregate(uint8_t tier, uint8_t channel, uint32_t from, uint32_t to, history_stat_t *p_stat)
+{
+  if (channel >= AQW_CHANNEL_COUNT)
+    return false;
+
+  switch (tier)
+  {
+  case HISTORY_RAW:
+  {
+    const int16_t *p_values = this->store->raw.value[channel];
+    return channel_stat(&this->store->raw, HISTORY_RAW_DEPTH, p_values, p_values, p_values, channel, from, to, p_stat);
+  }
+  case HISTORY_MINUTE:
+  {
+    history_rollup_tier_t<HISTORY_MINUTE_DEPTH> *p_tier = &this->store->minute;
+    return channel_stat(p_tier, HISTORY_MINUTE_DEPTH, p_tier->min[channel], p_tier->mean[channel], p_tier->max[channel],
+                        channel, from, to, p_stat);
+  }
+  case HISTORY_HOUR:
+  {
+    history_rollup_tier_t<HISTORY_HOUR_DEPTH> *p_tier = &this->store->hour;
+    return channel_stat(p_tier, HISTORY_HOUR_DEPTH, p_tier->min[channel], p_tier->mean[channel], p_tier->max[channel],
+                        channel, from, to, p_stat);
+  }
+  }
+
+  return false;
+}
@@ -0,0 +1,134 @@
+/*
+ * Project Particle Squared
+ * Description: Tiered reading history kept in retained RAM
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "aqw_data.h"
+
+// Depth of each tier. Everything lives in retained RAM, which the history
+// shares with the library state (AQW_RETAINED_BYTES). At the default depths
+// the store is about 2.5 KB: raw 32 * 15 B, minute 30 * 35 B, hour 24 * 35 B
+// plus two accumulators. Changing a depth resets the history on the next boot.
+#ifndef HISTORY_RAW_DEPTH
+#define HISTORY_RAW_DEPTH 32
+#endif
+#ifndef HISTORY_MINUTE_DEPTH
+#define HISTORY_MINUTE_DEPTH 30
+#endif
+#ifndef HISTORY_HOUR_DEPTH
+#define HISTORY_HOUR_DEPTH 24
+#endif
+#ifndef HISTORY_BUDGET_BYTES
+#define HISTORY_BUDGET_BYTES 2800
+#endif
+
+#define HISTORY_MAGIC 0x48495354
+#define HISTORY_VERSION 2
+
+// Tiers
+enum
+{
+  HISTORY_RAW,
+  HISTORY_MINUTE,
+  HISTORY_HOUR,
+};
+
+// Full resolution readings. One array per channel so scans stay sequential.
+template <uint16_t N>
+struct history_raw_tier_t
+{
+  uint32_t timestamp[N];
+  int16_t value[AQW_CHANNEL_COUNT][N];
+  uint8_t present[N]; // Bit per channel
+  uint16_t head, count;
+};
+
+// Rolled up min/mean/max per period
+template <uint16_t N>
+struct history_rollup_tier_t
+{
+  uint32_t timestamp[N]; // Start of the period
+  int16_t min[AQW_CHANNEL_COUNT][N];
+  int16_t mean[AQW_CHANNEL_COUNT][N];
+  int16_t max[AQW_CHANNEL_COUNT][N];
+  uint8_t present[N];
+  uint16_t head, count;
+};
+
+// Period currently being rolled up
+typedef struct
+{
+  uint32_t start;
+  int32_t sum[AQW_CHANNEL_COUNT];
+  uint16_t count[AQW_CHANNEL_COUNT];
+  int16_t min[AQW_CHANNEL_COUNT];
+  int16_t max[AQW_CHANNEL_COUNT];
+} history_accumulator_t;
+
+typedef struct
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t size; // sizeof(history_store_t), catches a depth change across a flash
+  history_raw_tier_t<HISTORY_RAW_DEPTH> raw;
+  history_rollup_tier_t<HISTORY_MINUTE_DEPTH> minute;
+  history_rollup_tier_t<HISTORY_HOUR_DEPTH> hour;
+  history_accumulator_t minute_acc;
+  history_accumulator_t hour_acc;
+} history_store_t;
+
+static_assert(sizeof(history_store_t) <= HISTORY_BUDGET_BYTES, "history exceeds HISTORY_BUDGET_BYTES");
+
+// One entry of any tier. Raw entries have min == mean == max.
+typedef struct
+{
+  uint32_t timestamp;
+  uint8_t present;
+  int16_t min[AQW_CHANNEL_COUNT];
+  int16_t mean[AQW_CHANNEL_COUNT];
+  int16_t max[AQW_CHANNEL_COUNT];
+} history_entry_t;
+
+typedef struct
+{
+  int16_t min;
+  int16_t mean;
+  int16_t max;
+  uint16_t count; // Entries that had the channel
+} history_stat_t;
+
+typedef void (*history_cb)(const history_entry_t *p_entry, void *p_context);
+
+class History
+{
+public:
+  History(void);
+
+  // Picks up retained data from before a reset, or starts empty
+  void begin();
+  void clear();
+
+  // O(1). Timestamps are Unix seconds and must not go backwards.
+  void add(uint32_t timestamp, const AirQualityWingData_t *p_data);
+
+  // Calls `callback` for every entry of `tier` in [from, to], oldest first.
+  // Returns the number of entries visited.
+  uint16_t query(uint8_t tier, uint32_t from, uint32_t to, history_cb callback, void *p_context);
+
+  // Min/mean/max of one channel across [from, to]. False if no entries had it.
+  bool aggregate(uint8_t tier, uint8_t channel, uint32_t from, uint32_t to, history_stat_t *p_stat);
+
+private:
+  void fold(history_accumulator_t *p_acc, uint8_t channel, int16_t min, int16_t max, int32_t sum, uint16_t count);
+  void flushMinute();
+  void flushHour();
+  history_store_t *store;
+};
+
+#endif //HISTORY_H
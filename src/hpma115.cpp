@@ -8,7 +8,9 @@
 
 #include "hpma115.h"
 
-HPMA115::HPMA115(void){}
+HPMA115::HPMA115(void){
+  AQW_STAT(memset(&this->stats,0,sizeof(this->stats)));
+}
 
 uint32_t HPMA115::setup(hpma115_init_t *p_init) {
 
@@ -79,18 +81,23 @@ void HPMA115::process() {
 
       // Read first byte in
       this->rx_buf[0] = Serial1.read();
+      AQW_STAT(this->stats.bytes++);
 
       // Make sure first byte is equal otherwise return
       if( this->rx_buf[0] != 0x42 ) {
+        AQW_STAT(this->stats.resyncs++);
         return;
       }
 
       // Reaad the second byte in
       this->rx_buf[1] = Serial1.read();
+      AQW_STAT(this->stats.bytes++);
 
       // Confirm its value
       if( this->rx_buf[1] == 0x4d ) {
         this->state = DATA_READ;
+      } else {
+        AQW_STAT(this->stats.resyncs++);
       }
 
     }
@@ -99,7 +106,14 @@ void HPMA115::process() {
     if( this->state == DATA_READ && Serial1.available() >= 30) {
 
       // Then read
-      Serial1.readBytes(this->rx_buf+2,30);
+      size_t len = Serial1.readBytes(this->rx_buf+2,30);
+      AQW_STAT(this->stats.bytes += len);
+
+      // Timed out part way, the rest of the buffer is the last frame's
+      if( len != 30 ) {
+        this->state = READY;
+        return;
+      }
 
       uint16_t calc_checksum = 0;
 
@@ -118,6 +132,8 @@ void HPMA115::process() {
       // sending the data
       if ( calc_checksum != data_checksum ) {
 
+        AQW_STAT(this->stats.checksum_errors++);
+
         Serial.println("hpma: checksum fail");
         Particle.publish("err", "hpma: checksum" , PRIVATE, NO_ACK);
 
@@ -127,6 +143,7 @@ void HPMA115::process() {
 
       // Increment the valid rx count
       this->rx_count++;
+      AQW_STAT(this->stats.frames++);
 
       // Take another reading. Minimum of HPMA115_READING_CNT readings
       if ( this->rx_count < HPMA115_READING_CNT ) {
@@ -162,3 +179,16 @@ hpma115_data_t HPMA115::getData() {
   return this->data;
 }
 
+#if AQW_STATS_ENABLED
+// Return copy of the counters
+perf_uart_t HPMA115::getStats(bool reset) {
+
+  perf_uart_t stats = this->stats;
+
+  if( reset ) {
+    memset(&this->stats,0,sizeof(this->stats));
+  }
+
+  return stats;
+}
+#endif
@@ -10,6 +10,8 @@
 #define HPMA115_H
 
 #include "application.h"
+#include "aqw_data.h"
+#include "perf_stats.h"
 
 #define HPMA115_BAUD 9600
 
@@ -32,11 +34,6 @@ typedef enum {
   DISABLED
 } hpma115_state_t;
 
-typedef struct {
-  uint16_t pm25;
-  uint16_t pm10;
-} hpma115_data_t;
-
 typedef std::function<void(void)> hpma115_cb;
 
 typedef struct {
@@ -53,6 +50,9 @@ class HPMA115 {
     bool is_enabled();
     void process();
     hpma115_data_t getData();
+#if AQW_STATS_ENABLED
+    perf_uart_t getStats(bool reset);
+#endif
   protected:
     hpma115_cb callback;
     hpma115_data_t data;
@@ -61,6 +61,9 @@ class HPMA115 {
     uint8_t enable_pin;
     uint8_t rx_count;
     char rx_buf[32];
+#if AQW_STATS_ENABLED
+    perf_uart_t stats;
+#endif
 };
 
 #endif //HPMA115_H
\ No newline at end of file
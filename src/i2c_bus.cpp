@@ -0,0 +1,316 @@
+/*
+ * Project Particle Squared
+ * Description: Shared I2C bus arbiter for the Sensirion sensors
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include "i2c_bus.h"
+#include "crc8_dallas.h"
+
+// Wrap safe "a is at or after b"
+static inline bool reached(uint32_t a, uint32_t b)
+{
+  return (int32_t)(a - b) >= 0;
+}
+
+// Lengths the descriptor buffers can hold
+static inline bool fits(const i2c_txn_t *p_txn)
+{
+  return p_txn->write_len <= I2C_BUS_MAX_WRITE && p_txn->read_len <= I2C_BUS_MAX_READ &&
+         p_txn->crc_words * CRC8_WORD_SIZE <= p_txn->read_len;
+}
+
+uint32_t i2c_txn_init(i2c_txn_t *p_txn, uint8_t address, const uint8_t *write, uint8_t write_len,
+                      uint32_t wait_us, uint8_t read_len, uint8_t crc_words)
+{
+  p_txn->address = address;
+  p_txn->write_len = write_len;
+  p_txn->wait_us = wait_us;
+  p_txn->read_len = read_len;
+  p_txn->crc_words = crc_words;
+  p_txn->retries = 0;
+  p_txn->retry_us = 0;
+  p_txn->busy_us = 0;
+  p_txn->state = I2C_TXN_IDLE;
+  p_txn->status = I2C_BUS_PENDING;
+
+  if (!fits(p_txn))
+  {
+    p_txn->status = I2C_BUS_TOO_LARGE;
+    return I2C_BUS_TOO_LARGE;
+  }
+
+  memcpy(p_txn->write, write, write_len);
+
+  return I2C_BUS_SUCCESS;
+}
+
+I2CBus::I2CBus(void) : count(0), window_start(0)
+{
+  this->getStats(true);
+  AQW_STAT(this->device_count = 0);
+}
+
+uint32_t I2CBus::submit(i2c_txn_t *p_txn)
+{
+  if (!fits(p_txn))
+    return I2C_BUS_TOO_LARGE;
+
+  if (this->count >= I2C_BUS_QUEUE_SIZE)
+    return I2C_BUS_QUEUE_FULL;
+
+  p_txn->state = I2C_TXN_QUEUED;
+  p_txn->status = I2C_BUS_PENDING;
+  p_txn->busy_us = 0;
+  AQW_STAT(p_txn->submitted_at = micros());
+  AQW_STAT(p_txn->retried = 0);
+  this->queue[this->count++] = p_txn;
+
+  return I2C_BUS_SUCCESS;
+}
+
+bool I2CBus::cancel(i2c_txn_t *p_txn)
+{
+  for (uint8_t i = 0; i < this->count; i++)
+  {
+    if (this->queue[i] != p_txn)
+      continue;
+
+    for (uint8_t j = i; j + 1 < this->count; j++)
+      this->queue[j] = this->queue[j + 1];
+
+    this->count--;
+    p_txn->state = I2C_TXN_IDLE;
+
+    return true;
+  }
+
+  return false;
+}
+
+void I2CBus::complete(uint8_t index, uint32_t status)
+{
+  i2c_txn_t *p_txn = this->queue[index];
+
+  p_txn->status = status;
+  p_txn->state = I2C_TXN_DONE;
+
+  this->stats.transactions++;
+  AQW_STAT(this->record(p_txn));
+
+  // Keep submission order for the rest
+  for (uint8_t i = index; i + 1 < this->count; i++)
+    this->queue[i] = this->queue[i + 1];
+
+  this->count--;
+}
+
+// Runs the next phase of a transaction. Returns true once it's done.
+bool I2CBus::step(i2c_txn_t *p_txn, uint32_t now)
+{
+  uint32_t start;
+
+  if (p_txn->state == I2C_TXN_QUEUED)
+  {
+    // Share the bus with application code
+    WITH_LOCK(Wire)
+    {
+      start = micros();
+      Wire.beginTransmission(p_txn->address);
+      Wire.write(p_txn->write, p_txn->write_len);
+      p_txn->status = Wire.endTransmission() == 0 ? I2C_BUS_SUCCESS : I2C_BUS_NACK;
+      p_txn->busy_us += micros() - start;
+      this->stats.busy_us += micros() - start;
+    }
+
+    if (p_txn->status != I2C_BUS_SUCCESS)
+    {
+      this->stats.nacks++;
+      return true;
+    }
+
+    // Free the bus for the conversion
+    p_txn->state = I2C_TXN_WAITING;
+    p_txn->ready_at = micros() + p_txn->wait_us;
+    return false;
+  }
+
+  if (p_txn->state != I2C_TXN_WAITING || !reached(now, p_txn->ready_at))
+    return false;
+
+  // Write only, the wait was all that was left
+  if (p_txn->read_len == 0)
+  {
+    p_txn->status = I2C_BUS_SUCCESS;
+    return true;
+  }
+
+  size_t received = 0;
+
+  WITH_LOCK(Wire)
+  {
+    start = micros();
+    received = Wire.requestFrom(p_txn->address, p_txn->read_len);
+
+    for (uint8_t i = 0; i < received && i < p_txn->read_len; i++)
+      p_txn->read[i] = Wire.read();
+
+    p_txn->busy_us += micros() - start;
+    this->stats.busy_us += micros() - start;
+  }
+
+  // Device still busy
+  if (received != p_txn->read_len)
+  {
+    this->stats.nacks++;
+
+    if (p_txn->retries == 0)
+    {
+      p_txn->status = I2C_BUS_NACK;
+      return true;
+    }
+
+    p_txn->retries--;
+    AQW_STAT(p_txn->retried++);
+    p_txn->ready_at = now + p_txn->retry_us;
+    return false;
+  }
+
+  if (crc8_check_words(p_txn->read, p_txn->crc_words) != CRC8_SUCCESS)
+  {
+    this->stats.crc_errors++;
+    p_txn->status = I2C_BUS_CRC_ERROR;
+    return true;
+  }
+
+  p_txn->status = I2C_BUS_SUCCESS;
+  return true;
+}
+
+void I2CBus::process()
+{
+  uint8_t i = 0;
+
+  while (i < this->count)
+  {
+    i2c_txn_t *p_txn = this->queue[i];
+
+    // Wait behind earlier transactions to the same device
+    bool blocked = false;
+    for (uint8_t j = 0; j < i; j++)
+    {
+      if (this->queue[j]->address == p_txn->address)
+      {
+        blocked = true;
+        break;
+      }
+    }
+
+    if (!blocked && this->step(p_txn, micros()))
+    {
+      this->complete(i, p_txn->status);
+
+      // Next in line for this device may go right away
+      i = 0;
+      continue;
+    }
+
+    i++;
+  }
+}
+
+bool I2CBus::isIdle()
+{
+  return this->count == 0;
+}
+
+bool I2CBus::nextDue(uint32_t *p_due)
+{
+  bool found = false;
+  uint32_t now = micros();
+
+  for (uint8_t i = 0; i < this->count; i++)
+  {
+    // Ready to write now
+    uint32_t due = this->queue[i]->state == I2C_TXN_WAITING ? this->queue[i]->ready_at : now;
+
+    if (!found || reached(*p_due, due))
+    {
+      *p_due = due;
+      found = true;
+    }
+  }
+
+  return found;
+}
+
+i2c_bus_stats_t I2CBus::getStats(bool reset)
+{
+  uint32_t now = micros();
+
+  this->stats.window_us = now - this->window_start;
+  i2c_bus_stats_t out = this->stats;
+
+  if (reset)
+  {
+    memset(&this->stats, 0, sizeof(this->stats));
+    this->window_start = now;
+  }
+
+  return out;
+}
+
+#if AQW_STATS_ENABLED
+void I2CBus::record(const i2c_txn_t *p_txn)
+{
+  perf_i2c_t *p_device = nullptr;
+
+  for (uint8_t i = 0; i < this->device_count; i++)
+  {
+    if (this->device_addresses[i] == p_txn->address)
+      p_device = &this->devices[i];
+  }
+
+  if (p_device == nullptr)
+  {
+    // Table is full, not counted
+    if (this->device_count >= I2C_BUS_MAX_DEVICES)
+      return;
+
+    this->device_addresses[this->device_count] = p_txn->address;
+    p_device = &this->devices[this->device_count++];
+    memset(p_device, 0, sizeof(perf_i2c_t));
+  }
+
+  p_device->transactions++;
+  p_device->retries += p_txn->retried;
+
+  if (p_txn->status == I2C_BUS_NACK)
+    p_device->nacks++;
+  else if (p_txn->status == I2C_BUS_CRC_ERROR)
+    p_device->crc_errors++;
+
+  perf_hist_add(&p_device->latency_us, micros() - p_txn->submitted_at);
+}
+
+bool I2CBus::getDeviceStats(uint8_t address, perf_i2c_t *p_stats, bool reset)
+{
+  for (uint8_t i = 0; i < this->device_count; i++)
+  {
+    if (this->device_addresses[i] != address)
+      continue;
+
+    *p_stats = this->devices[i];
+
+    if (reset)
+      memset(&this->devices[i], 0, sizeof(perf_i2c_t));
+
+    return true;
+  }
+
+  memset(p_stats, 0, sizeof(perf_i2c_t));
+  return false;
+}
+#endif
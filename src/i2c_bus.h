@@ -0,0 +1,119 @@
+/*
+ * Project Particle Squared
+ * Description: Shared I2C bus arbiter for the Sensirion sensors
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include "application.h"
+#include "perf_stats.h"
+
+#define I2C_BUS_QUEUE_SIZE 6
+#define I2C_BUS_MAX_WRITE 8
+#define I2C_BUS_MAX_READ 6
+#define I2C_BUS_MAX_DEVICES 4
+
+// Error codes
+#define I2C_BUS_SUCCESS 0
+#define I2C_BUS_QUEUE_FULL 1
+#define I2C_BUS_PENDING 2
+#define I2C_BUS_NACK 3
+#define I2C_BUS_CRC_ERROR 4
+#define I2C_BUS_TOO_LARGE 5
+
+typedef enum
+{
+  I2C_TXN_IDLE,
+  I2C_TXN_QUEUED,
+  I2C_TXN_WAITING,
+  I2C_TXN_DONE,
+} i2c_txn_state_t;
+
+// One write, wait, read sequence. Owned by the driver, queued by pointer.
+typedef struct
+{
+  uint8_t address;
+  uint8_t write[I2C_BUS_MAX_WRITE];
+  uint8_t write_len;
+  uint32_t wait_us;   // After the write, before the first read attempt
+  uint8_t read_len;   // 0 for write only
+  uint8_t crc_words;  // Sensirion words in `read` to verify
+  uint8_t retries;    // Read attempts while the device NACKs
+  uint32_t retry_us;  // Between read attempts
+
+  // Filled in by the bus
+  uint8_t read[I2C_BUS_MAX_READ];
+  i2c_txn_state_t state;
+  uint32_t status;
+  uint32_t ready_at;
+  uint32_t busy_us; // Time this transaction held the bus
+#if AQW_STATS_ENABLED
+  uint32_t submitted_at;
+  uint8_t retried;
+#endif
+} i2c_txn_t;
+
+typedef struct
+{
+  uint32_t busy_us;   // Time spent driving the bus
+  uint32_t window_us; // Time since the last reset
+  uint32_t transactions;
+  uint32_t nacks;
+  uint32_t crc_errors;
+} i2c_bus_stats_t;
+
+// Sets up a transaction descriptor. I2C_BUS_TOO_LARGE if the write or read
+// doesn't fit the descriptor, which submit() then refuses as well.
+uint32_t i2c_txn_init(i2c_txn_t *p_txn, uint8_t address, const uint8_t *write, uint8_t write_len,
+                  uint32_t wait_us, uint8_t read_len, uint8_t crc_words);
+
+// Interleaves queued transactions. A device's conversion wait is used
+// for other devices' transfers. Transactions to the same address run in order.
+class I2CBus
+{
+public:
+  I2CBus(void);
+
+  uint32_t submit(i2c_txn_t *p_txn);
+
+  // Takes a transaction back off the queue before it completes.
+  // False if it wasn't queued.
+  bool cancel(i2c_txn_t *p_txn);
+
+  // Runs every step that is due. Never blocks on a conversion.
+  void process();
+
+  bool isIdle();
+
+  // micros() time of the next step. False if idle.
+  bool nextDue(uint32_t *p_due);
+
+  // Utilization is busy_us / window_us
+  i2c_bus_stats_t getStats(bool reset);
+
+#if AQW_STATS_ENABLED
+  // Counters for one device. False if nothing was sent to `address` yet.
+  bool getDeviceStats(uint8_t address, perf_i2c_t *p_stats, bool reset);
+#endif
+
+private:
+  bool step(i2c_txn_t *p_txn, uint32_t now);
+  void complete(uint8_t index, uint32_t status);
+  i2c_txn_t *queue[I2C_BUS_QUEUE_SIZE];
+  uint8_t count;
+  i2c_bus_stats_t stats;
+  uint32_t window_start;
+
+#if AQW_STATS_ENABLED
+  uint8_t device_addresses[I2C_BUS_MAX_DEVICES];
+  perf_i2c_t devices[I2C_BUS_MAX_DEVICES];
+  uint8_t device_count;
+  void record(const i2c_txn_t *p_txn);
+#endif
+};
+
+#endif //I2C_BUS_H
@@ -0,0 +1,145 @@
+/*
+ * Project Particle Squared
+ * Description: Allocation free JSON serializer for readings
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include <string.h>
+#include "json_writer.h"
+
+typedef struct
+{
+  char *p_buf;
+  size_t size;
+  size_t len;
+  bool overflow;
+} json_out_t;
+
+static void put_str(json_out_t *p_out, const char *str, size_t len)
+{
+  if (p_out->len + len >= p_out->size)
+  {
+    p_out->overflow = true;
+    return;
+  }
+
+  memcpy(&p_out->p_buf[p_out->len], str, len);
+  p_out->len += len;
+}
+
+static void put_uint(json_out_t *p_out, uint32_t value, uint8_t min_digits)
+{
+  char digits[10];
+  uint8_t pos = sizeof(digits);
+
+  // Least significant first, from the back
+  do
+  {
+    digits[--pos] = '0' + value % 10;
+    value /= 10;
+  } while (value != 0 || sizeof(digits) - pos < min_digits);
+
+  put_str(p_out, &digits[pos], sizeof(digits) - pos);
+}
+
+static void put_int(json_out_t *p_out, int32_t value)
+{
+  if (value < 0)
+  {
+    put_str(p_out, "-", 1);
+    put_uint(p_out, -(uint32_t)value, 1);
+  }
+  else
+  {
+    put_uint(p_out, value, 1);
+  }
+}
+
+// Hundredths as a decimal with two places
+static void put_centi(json_out_t *p_out, int32_t value)
+{
+  uint32_t abs = value < 0 ? -(uint32_t)value : value;
+
+  if (value < 0)
+    put_str(p_out, "-", 1);
+
+  put_uint(p_out, abs / 100, 1);
+  put_str(p_out, ".", 1);
+  put_uint(p_out, abs % 100, 2);
+}
+
+// Key with its leading comma if needed
+static void put_key(json_out_t *p_out, const char *key, size_t len)
+{
+  if (p_out->len > 1)
+    put_str(p_out, ",", 1);
+
+  put_str(p_out, key, len);
+}
+
+#define PUT_KEY(p_out, key) put_key(p_out, key, sizeof(key) - 1)
+
+size_t json_write(const AirQualityWingData_t *p_data, uint32_t fields, char *p_buf, size_t size)
+{
+  json_out_t out = {p_buf, size, 0, false};
+
+  put_str(&out, "{", 1);
+
+  if (p_data->hpma115.hasData)
+  {
+    if (fields & JSON_FIELD_PM25)
+    {
+      PUT_KEY(&out, "\"pm25\":");
+      put_uint(&out, p_data->hpma115.data.pm25, 1);
+    }
+
+    if (fields & JSON_FIELD_PM10)
+    {
+      PUT_KEY(&out, "\"pm10\":");
+      put_uint(&out, p_data->hpma115.data.pm10, 1);
+    }
+  }
+
+  if (p_data->shtc3.hasData)
+  {
+    if (fields & JSON_FIELD_TEMPERATURE)
+    {
+      PUT_KEY(&out, "\"temperature\":");
+      put_centi(&out, p_data->shtc3.data.temperature);
+    }
+
+    if (fields & JSON_FIELD_HUMIDITY)
+    {
+      PUT_KEY(&out, "\"humidity\":");
+      put_centi(&out, p_data->shtc3.data.humidity);
+    }
+  }
+
+  if (p_data->sgp40.hasData && (fields & JSON_FIELD_TVOC))
+  {
+    PUT_KEY(&out, "\"tvoc\":");
+    put_int(&out, p_data->sgp40.data.tvoc);
+  }
+
+  if (p_data->aqi.hasData && (fields & JSON_FIELD_AQI))
+  {
+    PUT_KEY(&out, "\"aqi\":");
+    put_uint(&out, p_data->aqi.data.aqi, 1);
+  }
+
+  put_str(&out, "}", 1);
+
+  if (out.overflow)
+  {
+    if (size > 0)
+      p_buf[0] = '\0';
+
+    return 0;
+  }
+
+  p_buf[out.len] = '\0';
+
+  return out.len;
+}
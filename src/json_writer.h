@@ -0,0 +1,42 @@
+/*
+ * Project Particle Squared
+ * Description: Allocation free JSON serializer for readings
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stddef.h>
+#include "aqw_data.h"
+
+// Field selection
+#define JSON_FIELD_PM25 (1 << 0)
+#define JSON_FIELD_PM10 (1 << 1)
+#define JSON_FIELD_TEMPERATURE (1 << 2)
+#define JSON_FIELD_HUMIDITY (1 << 3)
+#define JSON_FIELD_TVOC (1 << 4)
+#define JSON_FIELD_AQI (1 << 5)
+
+// Sensor fields, the toString() payload. AQI is opt-in so that stays unchanged.
+#define JSON_FIELD_ALL 0x1f
+
+// Longest possible output, every field including aqi at its widest value, plus
+// the terminator. 99 bytes, 88 without aqi.
+#define JSON_MAX_SIZE                                   \
+  (sizeof("{}") - 1 + 5 +                               \
+   sizeof("\"pm25\":") - 1 + sizeof("65535") - 1 +      \
+   sizeof("\"pm10\":") - 1 + sizeof("65535") - 1 +      \
+   sizeof("\"temperature\":") - 1 + sizeof("-327.68") - 1 + \
+   sizeof("\"humidity\":") - 1 + sizeof("655.35") - 1 +  \
+   sizeof("\"tvoc\":") - 1 + sizeof("-2147483648") - 1 + \
+   sizeof("\"aqi\":") - 1 + sizeof("65535") - 1 +     \
+   1)
+
+// Writes the selected fields that have data into `p_buf`, NUL terminated.
+// Returns the number of bytes written without the terminator, 0 if it didn't fit.
+size_t json_write(const AirQualityWingData_t *p_data, uint32_t fields, char *p_buf, size_t size);
+
+#endif //JSON_WRITER_H
@@ -0,0 +1,121 @@
+/*
+ * Project Particle Squared
+ * Description: On-flash reading log format, shared with host tools
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include <string.h>
+
+#include "log_format.h"
+#include "crc32.h"
+
+static void put_u32(uint8_t *p_buf, uint32_t value)
+{
+  p_buf[0] = value;
+  p_buf[1] = value >> 8;
+  p_buf[2] = value >> 16;
+  p_buf[3] = value >> 24;
+}
+
+static uint32_t get_u32(const uint8_t *p_buf)
+{
+  return p_buf[0] | (p_buf[1] << 8) | (p_buf[2] << 16) | ((uint32_t)p_buf[3] << 24);
+}
+
+size_t log_segment_encode(const log_segment_t *p_segment, uint8_t *p_buf, size_t size)
+{
+  if (size < LOG_SEGMENT_HEADER_SIZE)
+    return 0;
+
+  memset(p_buf, 0, LOG_SEGMENT_HEADER_SIZE);
+  put_u32(&p_buf[0], LOG_SEGMENT_MAGIC);
+  p_buf[4] = LOG_VERSION;
+  put_u32(&p_buf[8], p_segment->segment);
+  put_u32(&p_buf[12], p_segment->first_seq);
+
+  return LOG_SEGMENT_HEADER_SIZE;
+}
+
+uint32_t log_segment_decode(const uint8_t *p_buf, size_t len, log_segment_t *p_segment)
+{
+  if (len < LOG_SEGMENT_HEADER_SIZE)
+    return LOG_TRUNCATED;
+
+  if (get_u32(&p_buf[0]) != LOG_SEGMENT_MAGIC)
+    return LOG_CORRUPT;
+
+  if (p_buf[4] != LOG_VERSION)
+    return LOG_BAD_VERSION;
+
+  p_segment->segment = get_u32(&p_buf[8]);
+  p_segment->first_seq = get_u32(&p_buf[12]);
+
+  return LOG_SUCCESS;
+}
+
+size_t log_record_encode(uint32_t seq, uint32_t timestamp, const AirQualityWingData_t *p_data, uint8_t *p_buf, size_t size)
+{
+  if (size < LOG_RECORD_HEADER_SIZE + LOG_RECORD_CRC_SIZE)
+    return 0;
+
+  size_t payload = record_encode(p_data, &p_buf[LOG_RECORD_HEADER_SIZE], size - LOG_RECORD_HEADER_SIZE - LOG_RECORD_CRC_SIZE);
+  if (payload == 0)
+    return 0;
+
+  p_buf[0] = LOG_RECORD_MAGIC;
+  p_buf[1] = payload;
+  put_u32(&p_buf[2], seq);
+  put_u32(&p_buf[6], timestamp);
+
+  size_t len = LOG_RECORD_HEADER_SIZE + payload;
+  put_u32(&p_buf[len], crc32(p_buf, len));
+
+  return len + LOG_RECORD_CRC_SIZE;
+}
+
+uint32_t log_record_decode(const uint8_t *p_buf, size_t len, log_record_t *p_record, size_t *p_used)
+{
+  if (len < LOG_RECORD_HEADER_SIZE)
+    return LOG_TRUNCATED;
+
+  if (p_buf[0] != LOG_RECORD_MAGIC || p_buf[1] > RECORD_MAX_SIZE)
+    return LOG_CORRUPT;
+
+  size_t body = LOG_RECORD_HEADER_SIZE + p_buf[1];
+  if (len < body + LOG_RECORD_CRC_SIZE)
+    return LOG_TRUNCATED;
+
+  if (crc32(p_buf, body) != get_u32(&p_buf[body]))
+    return LOG_CORRUPT;
+
+  size_t used;
+  if (record_decode(&p_buf[LOG_RECORD_HEADER_SIZE], p_buf[1], &p_record->data, &used) != RECORD_SUCCESS || used != p_buf[1])
+    return LOG_CORRUPT;
+
+  p_record->seq = get_u32(&p_buf[2]);
+  p_record->timestamp = get_u32(&p_buf[6]);
+
+  if (p_used != nullptr)
+    *p_used = body + LOG_RECORD_CRC_SIZE;
+
+  return LOG_SUCCESS;
+}
+
+size_t log_parse(const uint8_t *p_buf, size_t len, log_record_cb callback, void *p_context)
+{
+  size_t offset = 0;
+  log_record_t record;
+  size_t used;
+
+  while (log_record_decode(&p_buf[offset], len - offset, &record, &used) == LOG_SUCCESS)
+  {
+    if (callback != nullptr && !callback(&record, p_context))
+      break;
+
+    offset += used;
+  }
+
+  return offset;
+}
@@ -0,0 +1,71 @@
+/*
+ * Project Particle Squared
+ * Description: On-flash reading log format, shared with host tools
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+// No Device OS dependencies so host tools can use it
+#include <stddef.h>
+#include "aqw_data.h"
+#include "record_codec.h"
+
+// Segment file layout, all integers little endian:
+//   header  "AQWL" magic, version, 3 reserved, segment id (u32), first seq (u32)
+//   records back to back until the end of the file:
+//     [0]      LOG_RECORD_MAGIC
+//     [1]      payload length
+//     [2..5]   sequence number
+//     [6..9]   timestamp, Unix seconds (0 if unknown)
+//     [10..]   payload, a record_codec record
+//     [last 4] CRC-32 of everything before it
+// A torn write at the end shows up as a truncated record or a CRC mismatch.
+#define LOG_SEGMENT_MAGIC 0x4c575141 // "AQWL"
+#define LOG_VERSION 1
+
+#define LOG_SEGMENT_HEADER_SIZE 16
+#define LOG_RECORD_MAGIC 0xa5
+#define LOG_RECORD_HEADER_SIZE 10
+#define LOG_RECORD_CRC_SIZE 4
+#define LOG_RECORD_MAX_SIZE (LOG_RECORD_HEADER_SIZE + RECORD_MAX_SIZE + LOG_RECORD_CRC_SIZE)
+
+// Error codes
+#define LOG_SUCCESS 0
+#define LOG_TRUNCATED 1
+#define LOG_CORRUPT 2
+#define LOG_BAD_VERSION 3
+
+typedef struct
+{
+  uint32_t segment;
+  uint32_t first_seq;
+} log_segment_t;
+
+typedef struct
+{
+  uint32_t seq;
+  uint32_t timestamp;
+  AirQualityWingData_t data;
+} log_record_t;
+
+// Return false to stop parsing
+typedef bool (*log_record_cb)(const log_record_t *p_record, void *p_context);
+
+size_t log_segment_encode(const log_segment_t *p_segment, uint8_t *p_buf, size_t size);
+uint32_t log_segment_decode(const uint8_t *p_buf, size_t len, log_segment_t *p_segment);
+
+// Returns bytes written, 0 if it didn't fit. LOG_RECORD_MAX_SIZE always fits.
+size_t log_record_encode(uint32_t seq, uint32_t timestamp, const AirQualityWingData_t *p_data, uint8_t *p_buf, size_t size);
+
+// Decodes one record. `p_used` (optional) gets the bytes consumed.
+uint32_t log_record_decode(const uint8_t *p_buf, size_t len, log_record_t *p_record, size_t *p_used);
+
+// Walks the records in `p_buf` until the first bad or incomplete one.
+// Returns the bytes of valid records, i.e. where the next one would start.
+size_t log_parse(const uint8_t *p_buf, size_t len, log_record_cb callback, void *p_context);
+
+#endif //LOG_FORMAT_H
@@ -0,0 +1,307 @@
+/*
+ * Project Particle Squared
+ * Description: Output sinks with their own encoding, batching and rate limits
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include <string.h>
+
+#include "output_pipeline.h"
+
+// Device OS logging on the device, quiet in host builds
+#if defined(PARTICLE)
+#include "application.h"
+#define OUTPUT_WARN(...) Log.warn(__VA_ARGS__)
+#else
+#define OUTPUT_WARN(...)
+#endif
+
+OutputPipeline::OutputPipeline(void)
+{
+  for (uint8_t i = 0; i < OUTPUT_MAX_SINKS; i++)
+    this->sinks[i].active = false;
+}
+
+int OutputPipeline::addSink(const output_sink_config_t *p_config, output_write_t write)
+{
+  for (uint8_t i = 0; i < OUTPUT_MAX_SINKS; i++)
+  {
+    output_sink_t *p_sink = &this->sinks[i];
+
+    if (p_sink->active)
+      continue;
+
+    p_sink->config = *p_config;
+    if (p_sink->config.batch == 0)
+      p_sink->config.batch = 1;
+    if (p_sink->config.burst == 0)
+      p_sink->config.burst = 1;
+
+    p_sink->write = write;
+    p_sink->queue.setPolicy(p_config->policy);
+    p_sink->queue.getStats(true);
+
+    this->resetWrite(p_sink);
+    p_sink->has_carry = false;
+
+    // Starts with a full bucket
+    p_sink->credit = p_sink->config.burst * p_sink->config.rate_ms;
+    p_sink->refilled_at = 0;
+    p_sink->writes = p_sink->readings = p_sink->bytes = p_sink->rejected = p_sink->rate_limited = 0;
+    p_sink->dropped_oversize = 0;
+    p_sink->oversize_logged = false;
+
+    p_sink->active = true;
+
+    return i;
+  }
+
+  return -1;
+}
+
+void OutputPipeline::removeSink(int id)
+{
+  if (id < 0 || id >= OUTPUT_MAX_SINKS)
+    return;
+
+  output_item_t item;
+  output_sink_t *p_sink = &this->sinks[id];
+
+  p_sink->active = false;
+  p_sink->write = nullptr;
+
+  // Anything left over is dropped
+  while (p_sink->queue.pop(&item))
+    ;
+}
+
+void OutputPipeline::push(uint32_t now, uint32_t timestamp, const AirQualityWingData_t *p_data)
+{
+  output_item_t item = {timestamp, now, *p_data};
+
+  for (uint8_t i = 0; i < OUTPUT_MAX_SINKS; i++)
+  {
+    if (this->sinks[i].active)
+      this->sinks[i].queue.push(item);
+  }
+}
+
+void OutputPipeline::resetWrite(output_sink_t *p_sink)
+{
+  p_sink->len = 0;
+  p_sink->count = 0;
+  p_sink->waiting = false;
+}
+
+// Adds one reading to the write being built. False if it doesn't fit.
+bool OutputPipeline::encode(output_sink_t *p_sink, const output_item_t *p_item)
+{
+  size_t written = 0;
+
+  switch (p_sink->config.encoding)
+  {
+  case OUTPUT_JSON:
+  {
+    bool array = p_sink->config.batch > 1;
+    size_t len = p_sink->len;
+
+    // Array brackets and separators, one byte kept back for the closing ]
+    if (array)
+    {
+      if (len + 2 > sizeof(p_sink->buf))
+        return false;
+
+      p_sink->buf[len++] = p_sink->count == 0 ? '[' : ',';
+    }
+
+    written = json_write(&p_item->data, JSON_FIELD_ALL, (char *)&p_sink->buf[len], sizeof(p_sink->buf) - len - (array ? 1 : 0));
+    if (written == 0)
+      return false;
+
+    p_sink->len = len + written;
+    return true;
+  }
+
+  case OUTPUT_BINARY:
+    written = record_encode(&p_item->data, &p_sink->buf[p_sink->len], sizeof(p_sink->buf) - p_sink->len);
+    p_sink->len += written;
+    return written > 0;
+
+  case OUTPUT_BATCH:
+  case OUTPUT_BATCH_BASE64:
+    if (p_sink->count == 0)
+      p_sink->batch.begin(p_sink->buf, sizeof(p_sink->buf));
+
+    return p_sink->batch.add(p_item->timestamp, &p_item->data);
+  }
+
+  return false;
+}
+
+// Completes the write. Can be called again if the sink turned it down.
+size_t OutputPipeline::finish(output_sink_t *p_sink, const uint8_t **p_out)
+{
+  *p_out = p_sink->buf;
+
+  switch (p_sink->config.encoding)
+  {
+  case OUTPUT_JSON:
+    if (p_sink->config.batch > 1)
+    {
+      p_sink->buf[p_sink->len] = ']';
+      return p_sink->len + 1;
+    }
+    return p_sink->len;
+
+  case OUTPUT_BINARY:
+    return p_sink->len;
+
+  case OUTPUT_BATCH:
+    return p_sink->batch.finish();
+
+  case OUTPUT_BATCH_BASE64:
+  {
+    size_t len = p_sink->batch.finish();
+
+    *p_out = (const uint8_t *)this->text;
+    return batch_base64(p_sink->buf, len, this->text, sizeof(this->text));
+  }
+  }
+
+  return 0;
+}
+
+void OutputPipeline::processSink(output_sink_t *p_sink, uint32_t now)
+{
+  output_sink_config_t *p_config = &p_sink->config;
+  bool full = false;
+
+  // Fill the write from the queue
+  while (p_sink->count < p_config->batch)
+  {
+    output_item_t item;
+
+    if (p_sink->has_carry)
+    {
+      item = p_sink->carry;
+      p_sink->has_carry = false;
+    }
+    else if (!p_sink->queue.pop(&item))
+    {
+      break;
+    }
+
+    if (!this->encode(p_sink, &item))
+    {
+      // Can never fit, drop it rather than get stuck
+      if (p_sink->count == 0)
+      {
+        p_sink->dropped_oversize++;
+
+        if (!p_sink->oversize_logged)
+        {
+          OUTPUT_WARN("output: sink %d dropped a reading larger than its %u byte buffer", (int)(p_sink - this->sinks),
+                      (unsigned)sizeof(p_sink->buf));
+          p_sink->oversize_logged = true;
+        }
+
+        continue;
+      }
+
+      p_sink->carry = item;
+      p_sink->has_carry = true;
+      full = true;
+      break;
+    }
+
+    if (p_sink->count == 0)
+      p_sink->first_at = item.queued_at;
+
+    p_sink->count++;
+  }
+
+  if (p_sink->count == 0)
+    return;
+
+  bool due = full || p_sink->count >= p_config->batch ||
+             (p_config->flush_ms > 0 && now - p_sink->first_at >= p_config->flush_ms);
+
+  if (!due)
+    return;
+
+  // Token bucket
+  if (p_config->rate_ms > 0)
+  {
+    if (p_sink->refilled_at != 0)
+    {
+      uint32_t cap = p_config->burst * p_config->rate_ms;
+      uint32_t credit = p_sink->credit + (now - p_sink->refilled_at);
+
+      p_sink->credit = credit > cap ? cap : credit;
+    }
+
+    p_sink->refilled_at = now;
+
+    if (p_sink->credit < p_config->rate_ms)
+    {
+      if (!p_sink->waiting)
+        p_sink->rate_limited++;
+
+      p_sink->waiting = true;
+      return;
+    }
+  }
+
+  const uint8_t *p_out;
+  size_t len = this->finish(p_sink, &p_out);
+
+  if (len == 0 || !p_sink->write(p_out, len))
+  {
+    p_sink->rejected++;
+    return;
+  }
+
+  p_sink->credit -= p_config->rate_ms;
+  p_sink->writes++;
+  p_sink->readings += p_sink->count;
+  p_sink->bytes += len;
+
+  this->resetWrite(p_sink);
+}
+
+void OutputPipeline::process(uint32_t now)
+{
+  for (uint8_t i = 0; i < OUTPUT_MAX_SINKS; i++)
+  {
+    if (this->sinks[i].active && this->sinks[i].write != nullptr)
+      this->processSink(&this->sinks[i], now);
+  }
+}
+
+output_sink_stats_t OutputPipeline::getStats(int id, bool reset)
+{
+  output_sink_stats_t stats = {};
+
+  if (id < 0 || id >= OUTPUT_MAX_SINKS)
+    return stats;
+
+  output_sink_t *p_sink = &this->sinks[id];
+
+  stats.queue = p_sink->queue.getStats(reset);
+  stats.writes = p_sink->writes;
+  stats.readings = p_sink->readings;
+  stats.bytes = p_sink->bytes;
+  stats.rejected = p_sink->rejected;
+  stats.rate_limited = p_sink->rate_limited;
+  stats.dropped_oversize = p_sink->dropped_oversize;
+
+  if (reset)
+  {
+    p_sink->writes = p_sink->readings = p_sink->bytes = p_sink->rejected = p_sink->rate_limited = 0;
+    p_sink->dropped_oversize = 0;
+  }
+
+  return stats;
+}
@@ -0,0 +1,130 @@
+/*
+ * Project Particle Squared
+ * Description: Output sinks with their own encoding, batching and rate limits
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef OUTPUT_PIPELINE_H
+#define OUTPUT_PIPELINE_H
+
+#include <functional>
+
+#include "aqw_data.h"
+#include "result_queue.h"
+#include "json_writer.h"
+#include "record_codec.h"
+#include "batch_encoder.h"
+
+#ifndef OUTPUT_MAX_SINKS
+#define OUTPUT_MAX_SINKS 4
+#endif
+
+// Readings waiting per sink
+#ifndef OUTPUT_QUEUE_DEPTH
+#define OUTPUT_QUEUE_DEPTH 8
+#endif
+
+// Largest single write. A batch fits a publish once base64 encoded.
+#define OUTPUT_BUFFER_SIZE BATCH_MAX_SIZE
+#define OUTPUT_TEXT_SIZE (BATCH_PUBLISH_DATA_LENGTH + 1)
+
+typedef enum
+{
+  OUTPUT_JSON,         // One object, or an array of them if batching
+  OUTPUT_BINARY,       // record_codec records back to back
+  OUTPUT_BATCH,        // batch_encoder batch
+  OUTPUT_BATCH_BASE64, // Same, as text for Particle.publish()
+} output_encoding_t;
+
+typedef struct
+{
+  output_encoding_t encoding;
+  uint8_t batch;      // Readings per write, fewer if the buffer fills first
+  uint32_t flush_ms;  // Write a partial batch once its oldest reading waited this long. 0 waits for a full one.
+  uint32_t rate_ms;   // Average time between writes, 0 for no limit
+  uint8_t burst;      // Writes allowed back to back after a quiet spell, at least 1 so a write always fits the bucket
+  result_queue_policy_t policy; // When the queue is full
+} output_sink_config_t;
+
+// Gets each encoded write. Return false if the sink can't take it right
+// now, it's offered again later and newer readings queue up behind it.
+typedef std::function<bool(const uint8_t *p_buf, size_t len)> output_write_t;
+
+typedef struct
+{
+  result_queue_stats_t queue; // Queued, dropped and overwritten readings
+  uint32_t writes;
+  uint32_t readings; // Readings in successful writes
+  uint32_t bytes;
+  uint32_t rejected;     // Writes the sink turned down
+  uint32_t rate_limited; // Writes that had to wait for the rate limit
+  uint32_t dropped_oversize; // Readings that don't fit the buffer even on their own
+} output_sink_stats_t;
+
+typedef struct
+{
+  uint32_t timestamp; // Unix seconds, 0 if unknown
+  uint32_t queued_at; // millis()
+  AirQualityWingData_t data;
+} output_item_t;
+
+typedef struct
+{
+  bool active;
+  output_sink_config_t config;
+  output_write_t write;
+  ResultQueue<output_item_t, OUTPUT_QUEUE_DEPTH> queue;
+
+  // Write being built
+  uint8_t buf[OUTPUT_BUFFER_SIZE];
+  size_t len;
+  uint8_t count;
+  uint32_t first_at;
+  BatchEncoder batch;
+
+  // Popped but didn't fit, goes first into the next write
+  bool has_carry;
+  output_item_t carry;
+
+  // Token bucket, in ms of credit
+  uint32_t credit;
+  uint32_t refilled_at;
+  bool waiting; // Due write is held by the rate limit
+
+  uint32_t writes, readings, bytes, rejected, rate_limited, dropped_oversize;
+  bool oversize_logged; // Warned once
+} output_sink_t;
+
+class OutputPipeline
+{
+public:
+  OutputPipeline(void);
+
+  // Returns the sink id, -1 if all OUTPUT_MAX_SINKS are taken
+  int addSink(const output_sink_config_t *p_config, output_write_t write);
+  void removeSink(int id);
+
+  // Queues a reading for every sink. Never waits on a sink, safe from another thread.
+  void push(uint32_t now, uint32_t timestamp, const AirQualityWingData_t *p_data);
+
+  // Makes the writes that are due, at most one per sink. Call from the
+  // application thread, a slow sink only holds up this call.
+  void process(uint32_t now);
+
+  output_sink_stats_t getStats(int id, bool reset = false);
+
+private:
+  bool encode(output_sink_t *p_sink, const output_item_t *p_item);
+  size_t finish(output_sink_t *p_sink, const uint8_t **p_out);
+  void resetWrite(output_sink_t *p_sink);
+  void processSink(output_sink_t *p_sink, uint32_t now);
+
+  output_sink_t sinks[OUTPUT_MAX_SINKS];
+
+  // Base64 scratch, only used while a write is made
+  char text[OUTPUT_TEXT_SIZE];
+};
+
+#endif //OUTPUT_PIPELINE_H
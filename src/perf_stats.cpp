@@ -0,0 +1,53 @@
+/*
+ * Project Particle Squared
+ * Description: Performance counters and log2 latency histograms
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include "perf_stats.h"
+
+#if AQW_STATS_ENABLED
+
+void perf_hist_add(perf_hist_t *p_hist, uint32_t value)
+{
+  uint8_t bucket = value > 1 ? 31 - __builtin_clz(value) : 0;
+
+  if (bucket >= PERF_HIST_BUCKETS)
+    bucket = PERF_HIST_BUCKETS - 1;
+
+  p_hist->buckets[bucket]++;
+  p_hist->count++;
+
+  if (value > p_hist->max)
+    p_hist->max = value;
+}
+
+uint32_t perf_hist_percentile(const perf_hist_t *p_hist, uint8_t percent)
+{
+  if (p_hist->count == 0)
+    return 0;
+
+  // Rank of the sample, rounded up
+  uint32_t rank = ((uint64_t)p_hist->count * percent + 99) / 100;
+  uint32_t seen = 0;
+
+  if (rank == 0)
+    rank = 1;
+
+  for (uint8_t i = 0; i < PERF_HIST_BUCKETS - 1; i++)
+  {
+    seen += p_hist->buckets[i];
+
+    if (seen >= rank)
+    {
+      uint32_t bound = (2UL << i) - 1;
+      return bound < p_hist->max ? bound : p_hist->max;
+    }
+  }
+
+  return p_hist->max;
+}
+
+#endif //AQW_STATS_ENABLED
@@ -0,0 +1,65 @@
+/*
+ * Project Particle Squared
+ * Description: Performance counters and log2 latency histograms
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+
+#include <stdint.h>
+
+// Set to 0 (for every file, i.e. as a compiler flag) to compile all
+// counters and the getPerfStats() style accessors out.
+#ifndef AQW_STATS_ENABLED
+#define AQW_STATS_ENABLED 1
+#endif
+
+#if AQW_STATS_ENABLED
+#define AQW_STAT(expr) expr
+#else
+#define AQW_STAT(expr)
+#endif
+
+#if AQW_STATS_ENABLED
+
+#define PERF_HIST_BUCKETS 16
+
+// Bucket 0 holds 0 and 1, bucket n holds [2^n, 2^(n+1)).
+// The last bucket is open ended.
+typedef struct
+{
+  uint32_t count;
+  uint32_t max;
+  uint32_t buckets[PERF_HIST_BUCKETS];
+} perf_hist_t;
+
+// Per I2C device
+typedef struct
+{
+  uint32_t transactions;
+  uint32_t nacks;      // Write NACKs and reads that ran out of retries
+  uint32_t crc_errors;
+  uint32_t retries;    // Read attempts repeated while the device was busy
+  perf_hist_t latency_us; // Submit to completion
+} perf_i2c_t;
+
+// Per UART device
+typedef struct
+{
+  uint32_t bytes;
+  uint32_t frames;     // Passed the checksum
+  uint32_t checksum_errors;
+  uint32_t resyncs;    // Bytes skipped looking for a frame header
+} perf_uart_t;
+
+void perf_hist_add(perf_hist_t *p_hist, uint32_t value);
+
+// Upper bound of the bucket the `percent` percentile falls in, 0 if empty
+uint32_t perf_hist_percentile(const perf_hist_t *p_hist, uint8_t percent);
+
+#endif //AQW_STATS_ENABLED
+
+#endif //PERF_STATS_H
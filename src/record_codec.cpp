@@ -0,0 +1,86 @@
+/*
+ * Project Particle Squared
+ * Description: Compact versioned binary encoding of a reading
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include <string.h>
+#include "record_codec.h"
+
+// Schema index is the AQW_CHANNEL_* index
+static_assert(RECORD_FIELD_COUNT == AQW_CHANNEL_COUNT, "record schema must cover every channel");
+
+const record_field_t record_schema[RECORD_FIELD_COUNT] = {
+    {"pm25", "ug/m3", 1, false},
+    {"pm10", "ug/m3", 1, false},
+    {"temperature", "C", 100, true},
+    {"humidity", "%RH", 100, false},
+    {"tvoc", "index", 1, true},
+};
+
+size_t record_encode(const AirQualityWingData_t *p_data, uint8_t *p_buf, size_t size)
+{
+  if (size < 2)
+    return 0;
+
+  uint8_t presence = 0;
+  size_t len = 2;
+
+  for (uint8_t i = 0; i < RECORD_FIELD_COUNT; i++)
+  {
+    int32_t value;
+
+    if (!aqw_channel_get(p_data, i, &value))
+      continue;
+
+    uint32_t raw = record_schema[i].is_signed ? zigzag_encode(value) : (uint32_t)value;
+    size_t written = varint_put(&p_buf[len], size - len, raw);
+
+    if (written == 0)
+      return 0;
+
+    len += written;
+    presence |= 1 << i;
+  }
+
+  p_buf[0] = RECORD_VERSION;
+  p_buf[1] = presence;
+
+  return len;
+}
+
+uint32_t record_decode(const uint8_t *p_buf, size_t len, AirQualityWingData_t *p_data, size_t *p_used)
+{
+  if (len < 2)
+    return RECORD_TRUNCATED;
+
+  if (p_buf[0] != RECORD_VERSION)
+    return RECORD_BAD_VERSION;
+
+  memset(p_data, 0, sizeof(AirQualityWingData_t));
+
+  uint8_t presence = p_buf[1];
+  size_t pos = 2;
+
+  for (uint8_t i = 0; i < RECORD_FIELD_COUNT; i++)
+  {
+    if ((presence & (1 << i)) == 0)
+      continue;
+
+    uint32_t raw;
+    size_t read = varint_get(&p_buf[pos], len - pos, &raw);
+
+    if (read == 0)
+      return RECORD_TRUNCATED;
+
+    pos += read;
+    aqw_channel_set(p_data, i, record_schema[i].is_signed ? zigzag_decode(raw) : (int32_t)raw);
+  }
+
+  if (p_used != nullptr)
+    *p_used = pos;
+
+  return RECORD_SUCCESS;
+}
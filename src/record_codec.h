@@ -0,0 +1,50 @@
+/*
+ * Project Particle Squared
+ * Description: Compact versioned binary encoding of a reading
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef RECORD_CODEC_H
+#define RECORD_CODEC_H
+
+#include <stddef.h>
+#include "aqw_data.h"
+#include "varint.h"
+
+// Layout (version 1):
+//   [0]    version
+//   [1]    presence bitmap, bit n set if record_schema[n] follows
+//   [2..]  present fields in schema order, each an unsigned LEB128 varint.
+//          Signed fields are zigzag encoded first.
+// Values are the library's fixed point integers, divide by `scale` for units.
+// The raw sensor words are not carried.
+#define RECORD_VERSION 1
+
+#define RECORD_FIELD_COUNT 5
+#define RECORD_MAX_SIZE (2 + RECORD_FIELD_COUNT * VARINT_MAX_SIZE)
+
+// Error codes
+#define RECORD_SUCCESS 0
+#define RECORD_TRUNCATED 1
+#define RECORD_BAD_VERSION 2
+
+typedef struct
+{
+  const char *name;
+  const char *unit;
+  uint16_t scale;
+  bool is_signed;
+} record_field_t;
+
+// Field order is part of the format. Only ever append.
+extern const record_field_t record_schema[RECORD_FIELD_COUNT];
+
+// Returns bytes written, 0 if it didn't fit. RECORD_MAX_SIZE always fits.
+size_t record_encode(const AirQualityWingData_t *p_data, uint8_t *p_buf, size_t size);
+
+// Decodes one record. `p_used` (optional) gets the bytes consumed.
+uint32_t record_decode(const uint8_t *p_buf, size_t len, AirQualityWingData_t *p_data, size_t *p_used);
+
+#endif //RECORD_CODEC_H
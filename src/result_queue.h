@@ -0,0 +1,118 @@
+/*
+ * Project Particle Squared
+ * Description: Fixed depth queue for handing readings to the application
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef RESULT_QUEUE_H
+#define RESULT_QUEUE_H
+
+#include <stdint.h>
+#include <mutex>
+
+#ifndef RESULT_QUEUE_DEPTH
+#define RESULT_QUEUE_DEPTH 4
+#endif
+
+// What to do with a new item when the queue is full
+typedef enum
+{
+  RESULT_QUEUE_DROP_NEWEST,
+  RESULT_QUEUE_OVERWRITE_OLDEST,
+} result_queue_policy_t;
+
+typedef struct
+{
+  uint32_t depth;      // Items waiting right now
+  uint32_t high_water; // Deepest the queue has been
+  uint32_t pushed;
+  uint32_t dropped;     // New items lost to RESULT_QUEUE_DROP_NEWEST
+  uint32_t overwritten; // Old items lost to RESULT_QUEUE_OVERWRITE_OLDEST
+} result_queue_stats_t;
+
+// Copies items in and out under a lock. Safe between one producer thread
+// and any number of consumers.
+template <typename T, uint8_t N = RESULT_QUEUE_DEPTH>
+class ResultQueue
+{
+public:
+  ResultQueue(void) : head(0), count(0), policy(RESULT_QUEUE_OVERWRITE_OLDEST), stats() {}
+
+  void setPolicy(result_queue_policy_t policy)
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->policy = policy;
+  }
+
+  // Returns false if the item was dropped
+  bool push(const T &item)
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->stats.pushed++;
+
+    if (this->count == N)
+    {
+      if (this->policy == RESULT_QUEUE_DROP_NEWEST)
+      {
+        this->stats.dropped++;
+        return false;
+      }
+
+      // Oldest makes room
+      this->head = (this->head + 1) % N;
+      this->count--;
+      this->stats.overwritten++;
+    }
+
+    this->items[(this->head + this->count) % N] = item;
+    this->count++;
+
+    if (this->count > this->stats.high_water)
+      this->stats.high_water = this->count;
+
+    return true;
+  }
+
+  // Returns false if empty
+  bool pop(T *p_item)
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    if (this->count == 0)
+      return false;
+
+    *p_item = this->items[this->head];
+    this->head = (this->head + 1) % N;
+    this->count--;
+
+    return true;
+  }
+
+  result_queue_stats_t getStats(bool reset)
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    this->stats.depth = this->count;
+    result_queue_stats_t out = this->stats;
+
+    if (reset)
+    {
+      this->stats = result_queue_stats_t();
+      this->stats.high_water = this->count;
+    }
+
+    return out;
+  }
+
+private:
+  T items[N];
+  uint8_t head, count;
+  result_queue_policy_t policy;
+  result_queue_stats_t stats;
+  std::mutex mutex;
+};
+
+#endif //RESULT_QUEUE_H
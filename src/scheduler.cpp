@@ -0,0 +1,170 @@
+/*
+ * Project Particle Squared
+ * Description: Cooperative millis() deadline scheduler
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include <string.h>
+
+#include "scheduler.h"
+
+// Wrap safe "a is at or after b"
+static inline bool reached(uint32_t a, uint32_t b)
+{
+  return (int32_t)(a - b) >= 0;
+}
+
+Scheduler::Scheduler(void)
+{
+  this->stopAll();
+}
+
+void Scheduler::start(uint8_t id, uint32_t now, uint32_t delay, uint32_t period)
+{
+  if (id >= SCHEDULER_MAX_TASKS)
+    return;
+
+  this->tasks[id].due = now + delay;
+  this->tasks[id].period = period;
+  this->tasks[id].active = true;
+}
+
+void Scheduler::stop(uint8_t id)
+{
+  if (id >= SCHEDULER_MAX_TASKS)
+    return;
+
+  this->tasks[id].active = false;
+}
+
+void Scheduler::stopAll()
+{
+  for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++)
+  {
+    this->tasks[i].due = 0;
+    this->tasks[i].period = 0;
+    this->tasks[i].active = false;
+  }
+}
+
+bool Scheduler::isActive(uint8_t id)
+{
+  return id < SCHEDULER_MAX_TASKS && this->tasks[id].active;
+}
+
+bool Scheduler::getTask(uint8_t id, scheduler_task_t *p_task)
+{
+  if (!this->isActive(id))
+    return false;
+
+  *p_task = this->tasks[id];
+  return true;
+}
+
+void Scheduler::setPeriod(uint8_t id, uint32_t now, uint32_t period)
+{
+  if (id >= SCHEDULER_MAX_TASKS)
+    return;
+
+  scheduler_task_t *p_task = &this->tasks[id];
+
+  // Keep the phase: count the new period from the last run
+  if (p_task->active && p_task->period != 0)
+  {
+    p_task->due = p_task->due - p_task->period + period;
+
+    if (reached(now, p_task->due))
+      p_task->due = now;
+  }
+  else if (p_task->active)
+  {
+    p_task->due = now + period;
+  }
+
+  p_task->period = period;
+}
+
+uint32_t Scheduler::spread(uint8_t slot, uint8_t slots, uint32_t period)
+{
+  if (slots == 0)
+    return 0;
+
+  return (period / slots) * slot;
+}
+
+uint8_t Scheduler::next(uint32_t now)
+{
+  uint8_t found = SCHEDULER_NONE;
+  uint32_t lateness = 0;
+
+  for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++)
+  {
+    scheduler_task_t *p_task = &this->tasks[i];
+
+    if (!p_task->active || !reached(now, p_task->due))
+      continue;
+
+    if (found == SCHEDULER_NONE || now - p_task->due > lateness)
+    {
+      found = i;
+      lateness = now - p_task->due;
+    }
+  }
+
+  if (found == SCHEDULER_NONE)
+    return SCHEDULER_NONE;
+
+  scheduler_task_t *p_task = &this->tasks[found];
+
+  if (p_task->period == 0)
+  {
+    p_task->active = false;
+  }
+  else
+  {
+    p_task->due += p_task->period;
+
+    // Skip missed periods instead of bursting to catch up
+    if (reached(now, p_task->due))
+      p_task->due = now + p_task->period;
+  }
+
+  return found;
+}
+
+bool Scheduler::nextDeadline(uint32_t *p_due)
+{
+  bool found = false;
+
+  for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++)
+  {
+    if (!this->tasks[i].active)
+      continue;
+
+    if (!found || reached(*p_due, this->tasks[i].due))
+    {
+      *p_due = this->tasks[i].due;
+      found = true;
+    }
+  }
+
+  return found;
+}
+
+void Scheduler::save(scheduler_task_t *p_tasks)
+{
+  memcpy(p_tasks, this->tasks, sizeof(this->tasks));
+}
+
+void Scheduler::restore(const scheduler_task_t *p_tasks, uint32_t shift)
+{
+  memcpy(this->tasks, p_tasks, sizeof(this->tasks));
+
+  for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++)
+  {
+    if (this->tasks[i].active)
+      this->tasks[i].due += shift;
+  }
+}
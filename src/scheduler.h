@@ -0,0 +1,65 @@
+/*
+ * Project Particle Squared
+ * Description: Cooperative millis() deadline scheduler
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SCHEDULER_MAX_TASKS 8
+#define SCHEDULER_NONE 0xff
+
+typedef struct
+{
+  uint32_t due;    // millis() deadline
+  uint32_t period; // 0 for one shot
+  bool active;
+} scheduler_task_t;
+
+// Tasks are identified by index. The owner decides what each one does.
+class Scheduler
+{
+public:
+  Scheduler(void);
+
+  // Arms a task `delay` ms from `now`. Repeats every `period` ms if non zero.
+  void start(uint8_t id, uint32_t now, uint32_t delay, uint32_t period);
+  void stop(uint8_t id);
+  void stopAll();
+  bool isActive(uint8_t id);
+
+  // Copy of one task. False if it isn't armed.
+  bool getTask(uint8_t id, scheduler_task_t *p_task);
+
+  // Changes the period, keeping the task's phase
+  void setPeriod(uint8_t id, uint32_t now, uint32_t period);
+
+  // Phase offset for `slot` of `slots` tasks sharing the bus,
+  // evenly spaced across the shortest period
+  static uint32_t spread(uint8_t slot, uint8_t slots, uint32_t period);
+
+  // Pops the most overdue task, SCHEDULER_NONE if nothing is due.
+  // Periodic tasks are re-armed, one shots are disarmed.
+  uint8_t next(uint32_t now);
+
+  // Earliest deadline of all active tasks. False if none are armed.
+  bool nextDeadline(uint32_t *p_due);
+
+  // Copies the task table out, e.g. to retained memory
+  void save(scheduler_task_t *p_tasks);
+
+  // Loads a saved task table, moving every deadline by `shift` ms
+  // to account for a clock that restarted or stopped
+  void restore(const scheduler_task_t *p_tasks, uint32_t shift);
+
+private:
+  scheduler_task_t tasks[SCHEDULER_MAX_TASKS];
+};
+
+#endif //SCHEDULER_H
@@ -0,0 +1,83 @@
+/*
+ * Project Particle Squared
+ * Description: Single writer sequence lock for publishing snapshots
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+// One writer, any number of lock free readers. Readers retry if a write
+// lands while they copy. The version counts completed writes.
+template <typename T>
+class Seqlock
+{
+  static_assert(std::is_trivially_copyable<T>::value, "Seqlock needs a plain struct");
+
+public:
+  Seqlock(void) : sequence(0), value() {}
+
+  // Writer side. Never blocks.
+  void write(const T &next)
+  {
+    uint32_t seq = this->sequence.load(std::memory_order_relaxed);
+
+    // Odd while the copy is in progress
+    this->sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    memcpy(&this->value, &next, sizeof(T));
+
+    this->sequence.store(seq + 2, std::memory_order_release);
+  }
+
+  // Consistent copy of the latest write
+  T read(uint32_t *p_version = nullptr) const
+  {
+    T out;
+    uint32_t before, after;
+
+    do
+    {
+      before = this->sequence.load(std::memory_order_acquire);
+
+      // Writer is mid copy
+      if (before & 1)
+        continue;
+
+      memcpy(&out, &this->value, sizeof(T));
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      after = this->sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    if (p_version != nullptr)
+      *p_version = before / 2;
+
+    return out;
+  }
+
+  uint32_t version() const
+  {
+    return this->sequence.load(std::memory_order_acquire) / 2;
+  }
+
+  // Cheap check before copying
+  bool changedSince(uint32_t version) const
+  {
+    return this->version() != version;
+  }
+
+private:
+  std::atomic<uint32_t> sequence;
+  T value;
+};
+
+#endif //SEQLOCK_H
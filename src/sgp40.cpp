@@ -6,31 +6,31 @@
  * License: GNU GPLv3
  */
 
-#include <math.h>
 #include "sgp40.h"
 #include "crc8_dallas.h"
 
-SGP40::SGP40() {}
+SGP40::SGP40() : bus(nullptr), pending(false) {}
 
-void SGP40::setReady()
+uint32_t SGP40::setup(I2CBus *p_bus)
 {
-  this->ready = true;
-}
 
-uint32_t SGP40::setup()
-{
+  this->bus = p_bus;
+  this->pending = false;
 
   // Init variables
-  this->ready = false;
   this->data_available = false;
   this->has_env = false;
   this->log = new Logger("sgp40");
 
   // Start measurements
   uint8_t cmd[] = SGP40_MEAS_RAW_NO_HUM_OR_TEMP_CMD;
-  Wire.beginTransmission(SGP40_ADDRESS);
-  Wire.write(cmd, sizeof(cmd));         // sends register address
-  uint8_t ret = Wire.endTransmission(); // stop transaction
+  uint8_t ret;
+  WITH_LOCK(Wire)
+  {
+    Wire.beginTransmission(SGP40_ADDRESS);
+    Wire.write(cmd, sizeof(cmd));   // sends register address
+    ret = Wire.endTransmission();   // stop transaction
+  }
 
   // Return an error if we have an error
   if (ret != 0)
@@ -42,12 +42,6 @@ uint32_t SGP40::setup()
   // Set up algorithm
   VocAlgorithm_init(&this->voc_params);
 
-  // Start sample timer to feed algorithm
-  this->timer = new Timer(SGP40_READ_INTERVAL, [this](void) -> void
-                          { return SGP40::setReady(); });
-
-  this->timer->start();
-
   return SGP40_SUCCESS;
 }
 
@@ -70,61 +64,79 @@ uint32_t SGP40::read(sgp40_data_t *p_data)
 uint32_t SGP40::read_data_check_crc(uint16_t *data)
 {
 
-  // Read tvoc data and get CRC
-  uint16_t temp = (Wire.read() << 8) + Wire.read();
-  uint8_t crc_calc = crc8_dallas_little((uint8_t *)&temp, 2);
-  uint8_t crc = Wire.read();
+  // Read tvoc data and its CRC
+  uint8_t buf[CRC8_WORD_SIZE];
+  for (uint8_t i = 0; i < sizeof(buf); i++)
+    buf[i] = Wire.read();
 
   // Return if CRC is incorrect
-  if (crc != crc_calc)
+  if (crc8_unpack_words(buf, 1, data) != CRC8_SUCCESS)
   {
-    this->log->error("crc fail %x %x", crc, crc_calc);
+    this->log->error("crc fail %x %x", buf[2], crc8_dallas(buf, 2));
     return SGP40_DATA_ERR;
   }
 
-  // Copy data over
-  *data = temp;
-
   // Return on success!
   return SGP40_SUCCESS;
 }
 
-uint32_t SGP40::process()
+void SGP40::prepareCommand(uint8_t *cmd)
 {
 
-  uint32_t err_code;
-
-  if (this->ready)
+  /* Copy the humidity and temperature settings if they exist */
+  if (this->has_env)
   {
+    memcpy(&cmd[2], &this->raw_humidity, sizeof(this->raw_humidity));
+    memcpy(&cmd[5], &this->raw_temperature, sizeof(this->raw_temperature));
+  }
+}
 
-    // Reset this var
-    this->ready = false;
+void SGP40::feed(uint16_t raw_tvoc)
+{
 
-    /* Prepare command */
-    uint8_t cmd[] = SGP40_MEAS_RAW_NO_HUM_OR_TEMP_CMD;
+  this->data.raw_tvoc = raw_tvoc;
 
-    /* Copy the humidity and temperature settings if they exist */
-    if (this->has_env)
-    {
-      memcpy(&cmd[2], &this->raw_humidity, sizeof(this->raw_humidity));
-      memcpy(&cmd[5], &this->raw_temperature, sizeof(this->raw_temperature));
-    }
+  // Feed SGP40 algorithm
+  VocAlgorithm_process(&this->voc_params, this->data.raw_tvoc, &this->data.tvoc);
+
+  // Print results
+  this->log->info("raw: %d index: %d", this->data.raw_tvoc, (int)this->data.tvoc);
+
+  // data is ready!
+  this->data_available = true;
+}
+
+uint32_t SGP40::process()
+{
+
+  uint32_t err_code;
+  uint16_t raw_tvoc;
 
+  /* Prepare command */
+  uint8_t cmd[] = SGP40_MEAS_RAW_NO_HUM_OR_TEMP_CMD;
+  this->prepareCommand(cmd);
+
+  uint8_t ret;
+  WITH_LOCK(Wire)
+  {
     Wire.beginTransmission(SGP40_ADDRESS);
-    Wire.write(cmd, sizeof(cmd));         // sends register address
-    uint8_t ret = Wire.endTransmission(); // stop transaction
+    Wire.write(cmd, sizeof(cmd));   // sends register address
+    ret = Wire.endTransmission();   // stop transaction
+  }
 
-    // Return on error
-    if (ret != 0)
-    {
-      this->log->error("error transfering bytes");
-      return SGP40_COMM_ERR;
-    }
+  // Return on error
+  if (ret != 0)
+  {
+    this->log->error("error transfering bytes");
+    return SGP40_COMM_ERR;
+  }
 
-    delay(30);
+  delay(SGP40_MEAS_TIME_US / 1000);
 
-    uint8_t bytes_recieved, retries = 0;
+  uint8_t bytes_recieved, retries = 0;
 
+  WITH_LOCK(Wire)
+  {
     while (true)
     {
 
@@ -136,7 +148,7 @@ uint32_t SGP40::process()
 
       retries++;
 
-      if (retries > 50)
+      if (retries > SGP40_MEAS_RETRIES)
       {
         this->log->error("exceeded retries.");
         return SGP40_COMM_ERR;
@@ -151,26 +163,96 @@ uint32_t SGP40::process()
     }
 
     // Get the TVOC data
-    err_code = this->read_data_check_crc(&this->data.raw_tvoc);
-    if (err_code != SGP40_SUCCESS)
-    {
-      this->log->error("crc failure");
-      return SGP40_DATA_ERR;
-    }
+    err_code = this->read_data_check_crc(&raw_tvoc);
+  }
 
-    // Feed SGP40 algorithm
-    VocAlgorithm_process(&this->voc_params, this->data.raw_tvoc, &this->data.tvoc);
+  if (err_code != SGP40_SUCCESS)
+  {
+    this->log->error("crc failure");
+    return SGP40_DATA_ERR;
+  }
 
-    // Print results
-    this->log->info("raw: %d index: %d", this->data.raw_tvoc, (int)this->data.tvoc);
+  this->feed(raw_tvoc);
+
+  return SGP40_SUCCESS;
+}
+
+uint32_t SGP40::start()
+{
 
-    // data is ready!
-    this->data_available = true;
+  if (this->bus == nullptr)
+  {
+    return SGP40_NULL_ERROR;
+  }
+
+  // Previous sample hasn't been collected
+  if (this->pending)
+  {
+    return SGP40_BUSY;
+  }
+
+  uint8_t cmd[] = SGP40_MEAS_RAW_NO_HUM_OR_TEMP_CMD;
+  this->prepareCommand(cmd);
+
+  // Conversion time is free for other devices on the bus
+  i2c_txn_init(&this->txn, SGP40_ADDRESS, cmd, sizeof(cmd), SGP40_MEAS_TIME_US, CRC8_WORD_SIZE, 1);
+  this->txn.retries = SGP40_MEAS_RETRIES;
+  this->txn.retry_us = SGP40_MEAS_RETRY_US;
+
+  if (this->bus->submit(&this->txn) != I2C_BUS_SUCCESS)
+  {
+    return SGP40_COMM_ERR;
+  }
+
+  this->pending = true;
+
+  return SGP40_SUCCESS;
+}
+
+uint32_t SGP40::poll()
+{
+
+  if (!this->pending)
+  {
+    return SGP40_RUN_ERROR;
+  }
+
+  if (this->txn.state != I2C_TXN_DONE)
+  {
+    return SGP40_BUSY;
   }
 
+  this->pending = false;
+
+  if (this->txn.status == I2C_BUS_CRC_ERROR)
+  {
+    this->log->error("crc failure");
+    return SGP40_DATA_ERR;
+  }
+  else if (this->txn.status != I2C_BUS_SUCCESS)
+  {
+    this->log->error("comm failure %d", (int)this->txn.status);
+    return SGP40_COMM_ERR;
+  }
+
+  this->feed((this->txn.read[0] << 8) | this->txn.read[1]);
+
   return SGP40_SUCCESS;
 }
 
+bool SGP40::isPending()
+{
+  return this->pending;
+}
+
+void SGP40::abort()
+{
+  if (this->bus != nullptr)
+    this->bus->cancel(&this->txn);
+
+  this->pending = false;
+}
+
 uint32_t SGP40::setEnv(uint8_t *raw_humidity, uint8_t *raw_temperature)
 {
 
@@ -179,4 +261,14 @@ uint32_t SGP40::setEnv(uint8_t *raw_humidity, uint8_t *raw_temperature)
   this->has_env = true;
 
   return SGP40_SUCCESS;
-}
\ No newline at end of file
+}
+
+void SGP40::getState(int32_t *p_state0, int32_t *p_state1)
+{
+  VocAlgorithm_get_states(&this->voc_params, p_state0, p_state1);
+}
+
+void SGP40::setState(int32_t state0, int32_t state1)
+{
+  VocAlgorithm_set_states(&this->voc_params, state0, state1);
+}
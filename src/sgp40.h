@@ -4,6 +4,8 @@
 #include "stdint.h"
 #include "application.h"
 #include "sensirion_voc_algorithm.h"
+#include "i2c_bus.h"
+#include "aqw_data.h"
 
 #define SGP40_ADDRESS 0x59
 
@@ -21,6 +23,9 @@
   }
 
 #define SGP40_READ_INTERVAL 1000
+#define SGP40_MEAS_TIME_US 30000
+#define SGP40_MEAS_RETRIES 50
+#define SGP40_MEAS_RETRY_US 1000
 
 // Error codes
 enum
@@ -31,35 +36,50 @@ enum
   SGP40_RUN_ERROR,
   SGP40_COMM_ERR,
   SGP40_DATA_ERR,
+  SGP40_BUSY,
 };
 
-typedef struct
-{
-  uint16_t raw_tvoc;
-  int32_t tvoc;
-} sgp40_data_t;
-
 class SGP40
 {
 public:
   SGP40(void);
-  uint32_t setup();
+  // The bus is only needed for the split phase sample
+  uint32_t setup(I2CBus *p_bus = nullptr);
   uint32_t enable(void);
   uint32_t setEnv(uint8_t *raw_humidity, uint8_t *raw_temperature);
   uint32_t read(sgp40_data_t *p_data);
+
+  // Takes one sample and feeds the VOC algorithm.
+  // Call every SGP40_READ_INTERVAL ms.
   uint32_t process();
 
+  // Split phase sample through the I2CBus. start() queues the measurement,
+  // poll() returns SGP40_BUSY until it's done and the algorithm is fed.
+  uint32_t start();
+  uint32_t poll();
+  bool isPending();
+
+  // Takes a sample that is still on the bus back off it
+  void abort();
+
+  // VOC algorithm state, to carry the baseline over a short sleep or reset
+  void getState(int32_t *p_state0, int32_t *p_state1);
+  void setState(int32_t state0, int32_t state1);
+
 private:
-  void setReady(void);
   uint32_t read_data_check_crc(uint16_t *data);
-  Timer *timer;
+  void prepareCommand(uint8_t *cmd);
+  void feed(uint16_t raw_tvoc);
   VocAlgorithmParams voc_params;
+  I2CBus *bus;
+  i2c_txn_t txn;
+  bool pending;
 
 protected:
   uint8_t raw_temperature[3], raw_humidity[3];
   uint16_t has_env;
   sgp40_data_t data;
-  bool ready, data_available;
+  bool data_available;
   Logger *log;
 };
 
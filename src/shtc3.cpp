@@ -6,18 +6,29 @@
  * License: GNU GPLv3
  */
 
-#include <math.h>
-
 #include "shtc3.h"
+#include "crc8_dallas.h"
 
-SHTC3::SHTC3(void) {}
+SHTC3::SHTC3(void) : low_power(false), pending(false), bus(nullptr), bus_time_us(0) {}
 
-uint32_t SHTC3::setup()
+uint32_t SHTC3::setup(bool low_power, I2CBus *p_bus)
 {
-  // Return error if we failed
-  if (Wire.requestFrom(SHTC3_ADDRESS, 1) == 0)
+  this->low_power = low_power;
+  this->bus = p_bus;
+
+  WITH_LOCK(Wire)
   {
-    return SHTC3_COMMS_FAIL_ERROR;
+    // May still be asleep from before a reset
+    this->wake();
+
+    // Return error if we failed
+    if (Wire.requestFrom(SHTC3_ADDRESS, 1) == 0)
+    {
+      return SHTC3_COMMS_FAIL_ERROR;
+    }
+
+    // Idle in sleep between reads
+    this->sleep();
   }
 
   this->log = new Logger("shtc3");
@@ -25,42 +36,198 @@ uint32_t SHTC3::setup()
   return SHTC3_SUCCESS;
 }
 
+uint32_t SHTC3::command(const uint8_t *cmd, uint8_t len)
+{
+  Wire.beginTransmission(SHTC3_ADDRESS);
+  Wire.write(cmd, len);
+
+  if (Wire.endTransmission() != 0)
+  {
+    return SHTC3_COMMS_FAIL_ERROR;
+  }
+
+  return SHTC3_SUCCESS;
+}
+
+uint32_t SHTC3::wake()
+{
+  uint8_t cmd[] = SHTC3_WAKE;
+  uint32_t err_code = this->command(cmd, sizeof(cmd));
+
+  // Sensor ignores commands until it's up
+  delayMicroseconds(SHTC3_WAKE_TIME_US);
+
+  return err_code;
+}
+
+uint32_t SHTC3::sleep()
+{
+  uint8_t cmd[] = SHTC3_SLEEP;
+  return this->command(cmd, sizeof(cmd));
+}
+
+uint32_t SHTC3::getMeasurementTime()
+{
+  return SHTC3_WAKE_TIME_US + (this->low_power ? SHTC3_MEAS_LP_TIME_US : SHTC3_MEAS_TIME_US);
+}
+
+uint32_t SHTC3::convert(const uint8_t *p_buf, shtc3_data_t *p_data)
+{
+
+  // Drop the reading if it was corrupted on the bus. The last good one stays.
+  if (crc8_check_words(p_buf, 2) != CRC8_SUCCESS)
+  {
+    return SHTC3_CRC_ERROR;
+  }
+
+  // Temperature word then humidity word
+  memcpy(p_data->raw_temperature, &p_buf[0], sizeof(p_data->raw_temperature));
+  memcpy(p_data->raw_humidity, &p_buf[3], sizeof(p_data->raw_humidity));
+
+  // T = -45 + 175 * raw / 2^16, in centi-°C (rounded)
+  uint32_t temp = (p_data->raw_temperature[0] << 8) | p_data->raw_temperature[1];
+  p_data->temperature = (int16_t)((temp * 17500 + 0x8000) >> 16) - 4500;
+
+  // RH = 100 * raw / 2^16, in centi-%RH (rounded)
+  uint32_t hum = (p_data->raw_humidity[0] << 8) | p_data->raw_humidity[1];
+  p_data->humidity = (hum * 10000 + 0x8000) >> 16;
+
+  return SHTC3_SUCCESS;
+}
+
 uint32_t SHTC3::read(shtc3_data_t *p_data)
 {
 
-  // SHTC3 Temperature
-  uint8_t temp_cmd[] = SHTC3_TEMP_HOLD_CMD;
-  Wire.beginTransmission(SHTC3_ADDRESS);
-  Wire.write(temp_cmd, sizeof(temp_cmd)); // sends bytes
-  Wire.endTransmission();                 // stop transaction
-  Wire.requestFrom(SHTC3_ADDRESS, 3);
+  uint8_t buf[SHTC3_MEAS_SIZE];
+  uint32_t start = micros();
 
-  // Get the raw temperature from the device
-  p_data->raw_temperature[0] = Wire.read() & 0xff;
-  p_data->raw_temperature[1] = Wire.read() & 0xff;
-  p_data->raw_temperature[2] = Wire.read() & 0xff;
+  // Keep the bus to ourselves for the whole clock stretched read
+  WITH_LOCK(Wire)
+  {
+    if (this->wake() != SHTC3_SUCCESS)
+    {
+      this->bus_time_us = micros() - start;
+      return SHTC3_COMMS_FAIL_ERROR;
+    }
 
-  // Then calculate the temperature
-  uint16_t temp = (p_data->raw_temperature[0] << 8) | p_data->raw_temperature[1];
-  p_data->temperature = (temp * 175) / pow(2, 16) - 45;
+    // One measurement returns temperature then humidity
+    uint8_t normal_cmd[] = SHTC3_MEAS_HOLD_CMD;
+    uint8_t lp_cmd[] = SHTC3_MEAS_LP_HOLD_CMD;
+    if (this->command(this->low_power ? lp_cmd : normal_cmd, sizeof(normal_cmd)) != SHTC3_SUCCESS)
+    {
+      this->sleep();
+      this->bus_time_us = micros() - start;
+      return SHTC3_COMMS_FAIL_ERROR;
+    }
 
-  // SHTC3 Humidity
-  uint8_t hum_cmd[] = SHTC3_HUMIDITY_HOLD_CMD;
-  Wire.beginTransmission(SHTC3_ADDRESS);
-  Wire.write(hum_cmd, sizeof(hum_cmd)); // sends bytes
-  Wire.endTransmission();               // stop transaction
-  Wire.requestFrom(SHTC3_ADDRESS, 3);
+    // Both words with their CRCs
+    if (Wire.requestFrom(SHTC3_ADDRESS, SHTC3_MEAS_SIZE) != SHTC3_MEAS_SIZE)
+    {
+      this->sleep();
+      this->bus_time_us = micros() - start;
+      return SHTC3_COMMS_FAIL_ERROR;
+    }
+
+    for (uint8_t i = 0; i < sizeof(buf); i++)
+      buf[i] = Wire.read() & 0xff;
+
+    // Back to sleep until the next read
+    this->sleep();
+  }
+
+  this->bus_time_us = micros() - start;
 
-  // Get the raw humidity value from the evice
-  p_data->raw_humidity[0] = Wire.read() & 0xff;
-  p_data->raw_humidity[1] = Wire.read() & 0xff;
-  p_data->raw_humidity[2] = Wire.read() & 0xff;
+  return this->convert(buf, p_data);
+}
+
+uint32_t SHTC3::start()
+{
+
+  if (this->bus == nullptr)
+  {
+    return SHTC3_NOT_STARTED;
+  }
+
+  // Wake, then a no clock stretching measurement. The sensor NACKs
+  // reads until it's done, the bus retries every millisecond.
+  uint8_t wake_cmd[] = SHTC3_WAKE;
+  uint8_t normal_cmd[] = SHTC3_MEAS_POLL_CMD;
+  uint8_t lp_cmd[] = SHTC3_MEAS_LP_POLL_CMD;
+  uint32_t meas_time_us = this->getMeasurementTime() - SHTC3_WAKE_TIME_US;
+
+  i2c_txn_init(&this->wake_txn, SHTC3_ADDRESS, wake_cmd, sizeof(wake_cmd), SHTC3_WAKE_TIME_US, 0, 0);
+  i2c_txn_init(&this->meas_txn, SHTC3_ADDRESS, this->low_power ? lp_cmd : normal_cmd, sizeof(normal_cmd),
+               meas_time_us, SHTC3_MEAS_SIZE, 2);
+  this->meas_txn.retries = (SHTC3_POLL_TIMEOUT_US - meas_time_us) / SHTC3_POLL_RETRY_US;
+  this->meas_txn.retry_us = SHTC3_POLL_RETRY_US;
+
+  if (this->bus->submit(&this->wake_txn) != I2C_BUS_SUCCESS)
+  {
+    return SHTC3_COMMS_FAIL_ERROR;
+  }
 
-  // Then calculate the teperature
-  uint16_t hum = (p_data->raw_humidity[0] << 8) | p_data->raw_humidity[1];
-  p_data->humidity = hum * 100 / pow(2, 16);
+  // Don't leave the wake up running on its own
+  if (this->bus->submit(&this->meas_txn) != I2C_BUS_SUCCESS)
+  {
+    this->bus->cancel(&this->wake_txn);
+    return SHTC3_COMMS_FAIL_ERROR;
+  }
 
-  // Serial.printf("hum: %.2f%% temp: %.2f°C\n", p_data->humidity, p_data->temperature);
+  this->pending = true;
 
   return SHTC3_SUCCESS;
-}
\ No newline at end of file
+}
+
+uint32_t SHTC3::poll(shtc3_data_t *p_data)
+{
+
+  if (!this->pending)
+  {
+    return SHTC3_NOT_STARTED;
+  }
+
+  if (this->meas_txn.state != I2C_TXN_DONE)
+  {
+    return SHTC3_BUSY;
+  }
+
+  this->pending = false;
+  this->bus_time_us = this->wake_txn.busy_us + this->meas_txn.busy_us;
+
+  // Back to sleep until the next read
+  uint8_t sleep_cmd[] = SHTC3_SLEEP;
+  i2c_txn_init(&this->sleep_txn, SHTC3_ADDRESS, sleep_cmd, sizeof(sleep_cmd), 0, 0, 0);
+  this->bus->submit(&this->sleep_txn);
+
+  if (this->meas_txn.status == I2C_BUS_CRC_ERROR)
+  {
+    return SHTC3_CRC_ERROR;
+  }
+  else if (this->meas_txn.status != I2C_BUS_SUCCESS)
+  {
+    return SHTC3_COMMS_FAIL_ERROR;
+  }
+
+  return this->convert(this->meas_txn.read, p_data);
+}
+
+bool SHTC3::isPending()
+{
+  return this->pending;
+}
+
+void SHTC3::abort()
+{
+  if (this->bus == nullptr)
+    return;
+
+  this->bus->cancel(&this->wake_txn);
+  this->bus->cancel(&this->meas_txn);
+  this->bus->cancel(&this->sleep_txn);
+  this->pending = false;
+}
+
+uint32_t SHTC3::getBusTime()
+{
+  return this->bus_time_us;
+}
@@ -10,18 +10,36 @@
 #define SHTC3_H
 
 #include "application.h"
+#include "i2c_bus.h"
+#include "aqw_data.h"
 
 #define SHTC3_ADDRESS 0x70
 
-#define SHTC3_TEMP_HOLD_CMD \
+// Normal mode, clock stretching, temperature first
+#define SHTC3_MEAS_HOLD_CMD \
   {                         \
     0x7C, 0xA2              \
   }
-#define SHTC3_HUMIDITY_HOLD_CMD \
-  {                             \
-    0x5C, 0x24                  \
+
+// Low power mode, clock stretching, temperature first
+#define SHTC3_MEAS_LP_HOLD_CMD \
+  {                            \
+    0x64, 0x58                 \
   }
 
+// Same measurements without clock stretching
+#define SHTC3_MEAS_POLL_CMD \
+  {                         \
+    0x78, 0x66              \
+  }
+#define SHTC3_MEAS_LP_POLL_CMD \
+  {                            \
+    0x60, 0x9C                 \
+  }
+
+// Temperature word + CRC, humidity word + CRC
+#define SHTC3_MEAS_SIZE 6
+
 #define SHTC3_SLEEP \
   {                 \
     0xB0, 0x98      \
@@ -32,26 +50,67 @@
     0x35, 0x17     \
   }
 
+// Timing (max values from the datasheet)
+#define SHTC3_WAKE_TIME_US 240
+#define SHTC3_MEAS_TIME_US 12100
+#define SHTC3_MEAS_LP_TIME_US 800
+#define SHTC3_POLL_TIMEOUT_US 50000
+#define SHTC3_POLL_RETRY_US 1000
+
 // Error code
 #define SHTC3_SUCCESS 0
 #define SHTC3_COMMS_FAIL_ERROR 1
+#define SHTC3_CRC_ERROR 2
+#define SHTC3_BUSY 3
+#define SHTC3_NOT_STARTED 4
 
-typedef struct
+// Float convenience getters. Not used in the read path.
+static inline float shtc3_temperature_c(const shtc3_data_t *p_data)
 {
-  uint8_t raw_temperature[3];
-  uint8_t raw_humidity[3];
-  float temperature;
-  float humidity;
-} shtc3_data_t;
+  return p_data->temperature * 0.01f;
+}
+
+static inline float shtc3_humidity_rh(const shtc3_data_t *p_data)
+{
+  return p_data->humidity * 0.01f;
+}
 
 class SHTC3
 {
 public:
   SHTC3(void);
-  uint32_t setup();
+  // The bus is only needed for the split phase read
+  uint32_t setup(bool low_power = false, I2CBus *p_bus = nullptr);
+
+  // Wakes the sensor, measures and puts it back to sleep
   uint32_t read(shtc3_data_t *p_data);
 
+  // Split phase read through the I2CBus. start() queues a no-stretch
+  // measurement and returns, poll() returns SHTC3_BUSY until it's done.
+  uint32_t start();
+  uint32_t poll(shtc3_data_t *p_data);
+  bool isPending();
+
+  // Takes a measurement that is still on the bus back off it
+  void abort();
+
+  // Worst case time for one read() including wake up, in microseconds.
+  // Cycles only wait for an SHTC3 reading that can finish inside them.
+  uint32_t getMeasurementTime();
+
+  // Time the last measurement held the bus, in microseconds
+  uint32_t getBusTime();
+
 private:
+  uint32_t command(const uint8_t *cmd, uint8_t len);
+  uint32_t wake();
+  uint32_t sleep();
+  uint32_t convert(const uint8_t *p_buf, shtc3_data_t *p_data);
+  bool low_power;
+  bool pending;
+  I2CBus *bus;
+  i2c_txn_t wake_txn, meas_txn, sleep_txn;
+  uint32_t bus_time_us;
   Logger *log;
 };
 
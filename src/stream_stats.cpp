@@ -0,0 +1,215 @@
+/*
+ * Project Particle Squared
+ * Description: Constant memory streaming statistics
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "stream_stats.h"
+
+void welford_reset(welford_t *p_w)
+{
+  memset(p_w, 0, sizeof(welford_t));
+}
+
+void welford_add(welford_t *p_w, float value)
+{
+  if (p_w->count == 0 || value < p_w->min)
+    p_w->min = value;
+  if (p_w->count == 0 || value > p_w->max)
+    p_w->max = value;
+
+  p_w->count++;
+
+  float delta = value - p_w->mean;
+  p_w->mean += delta / p_w->count;
+  p_w->m2 += delta * (value - p_w->mean);
+}
+
+// Sample variance
+float welford_variance(const welford_t *p_w)
+{
+  if (p_w->count < 2)
+    return 0.0f;
+
+  return p_w->m2 / (p_w->count - 1);
+}
+
+void p2_reset(p2_t *p_p2, float p)
+{
+  memset(p_p2, 0, sizeof(p2_t));
+  p_p2->p = p;
+}
+
+// Piecewise parabolic prediction of marker i moved by d
+static float p2_parabolic(const p2_t *p_p2, uint8_t i, int32_t d)
+{
+  const float *q = p_p2->q;
+  const int32_t *n = p_p2->n;
+
+  return q[i] + (float)d / (n[i + 1] - n[i - 1]) *
+                    ((n[i] - n[i - 1] + d) * (q[i + 1] - q[i]) / (n[i + 1] - n[i]) +
+                     (n[i + 1] - n[i] - d) * (q[i] - q[i - 1]) / (n[i] - n[i - 1]));
+}
+
+void p2_add(p2_t *p_p2, float value)
+{
+  float *q = p_p2->q;
+  int32_t *n = p_p2->n;
+  float *np = p_p2->np;
+  float p = p_p2->p;
+
+  // Collect the first five, kept sorted
+  if (p_p2->count < P2_MARKERS)
+  {
+    uint8_t i = p_p2->count++;
+
+    while (i > 0 && q[i - 1] > value)
+    {
+      q[i] = q[i - 1];
+      i--;
+    }
+    q[i] = value;
+
+    if (p_p2->count == P2_MARKERS)
+    {
+      for (uint8_t j = 0; j < P2_MARKERS; j++)
+        n[j] = j;
+
+      np[0] = 0;
+      np[1] = 2 * p;
+      np[2] = 4 * p;
+      np[3] = 2 + 2 * p;
+      np[4] = 4;
+    }
+
+    return;
+  }
+
+  p_p2->count++;
+
+  // Find the cell and stretch the ends if needed
+  uint8_t k;
+  if (value < q[0])
+  {
+    q[0] = value;
+    k = 0;
+  }
+  else if (value >= q[4])
+  {
+    q[4] = value;
+    k = 3;
+  }
+  else
+  {
+    k = 0;
+    while (value >= q[k + 1])
+      k++;
+  }
+
+  for (uint8_t i = k + 1; i < P2_MARKERS; i++)
+    n[i]++;
+
+  const float dn[P2_MARKERS] = {0, p / 2, p, (1 + p) / 2, 1};
+  for (uint8_t i = 0; i < P2_MARKERS; i++)
+    np[i] += dn[i];
+
+  // Nudge the middle markers back towards where they should be
+  for (uint8_t i = 1; i < P2_MARKERS - 1; i++)
+  {
+    float d = np[i] - n[i];
+
+    if ((d >= 1 && n[i + 1] - n[i] > 1) || (d <= -1 && n[i - 1] - n[i] < -1))
+    {
+      int32_t ds = d > 0 ? 1 : -1;
+      float qp = p2_parabolic(p_p2, i, ds);
+
+      if (q[i - 1] < qp && qp < q[i + 1])
+        q[i] = qp;
+      else
+        q[i] += ds * (q[i + ds] - q[i]) / (n[i + ds] - n[i]);
+
+      n[i] += ds;
+    }
+  }
+}
+
+float p2_value(const p2_t *p_p2)
+{
+  if (p_p2->count == 0)
+    return 0.0f;
+
+  // Too few for markers, the samples are still sorted in q
+  if (p_p2->count < P2_MARKERS)
+  {
+    uint8_t i = (uint8_t)(p_p2->p * (p_p2->count - 1) + 0.5f);
+    return p_p2->q[i];
+  }
+
+  return p_p2->q[2];
+}
+
+StreamStats::StreamStats(void)
+{
+  this->setup(STREAM_STATS_WINDOW_MS, STREAM_STATS_QUANTILE);
+}
+
+void StreamStats::setup(uint32_t window_ms, float quantile)
+{
+  this->window = window_ms;
+  this->quantile = quantile;
+  this->reset();
+  this->last.count = 0;
+}
+
+void StreamStats::reset()
+{
+  welford_reset(&this->welford);
+  p2_reset(&this->p2, this->quantile);
+  this->start = 0;
+  this->end = 0;
+}
+
+void StreamStats::add(uint32_t now, float value)
+{
+  // Close the window once it's run its length
+  if (this->welford.count > 0 && this->window > 0 && now - this->start >= this->window)
+  {
+    this->snapshot(&this->last);
+    this->reset();
+  }
+
+  if (this->welford.count == 0)
+    this->start = now;
+
+  this->end = now;
+
+  welford_add(&this->welford, value);
+  p2_add(&this->p2, value);
+}
+
+void StreamStats::snapshot(stream_stats_t *p_stats)
+{
+  p_stats->count = this->welford.count;
+  p_stats->mean = this->welford.mean;
+  p_stats->stddev = sqrtf(welford_variance(&this->welford));
+  p_stats->min = this->welford.min;
+  p_stats->max = this->welford.max;
+  p_stats->quantile = p2_value(&this->p2);
+  p_stats->start = this->start;
+  p_stats->end = this->end;
+}
+
+bool StreamStats::get(stream_stats_t *p_stats, bool current)
+{
+  if (current)
+    this->snapshot(p_stats);
+  else
+    *p_stats = this->last;
+
+  return p_stats->count > 0;
+}
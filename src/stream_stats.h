@@ -0,0 +1,89 @@
+/*
+ * Project Particle Squared
+ * Description: Constant memory streaming statistics
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef STREAM_STATS_H
+#define STREAM_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Defaults
+#define STREAM_STATS_WINDOW_MS (60 * 60 * 1000)
+#define STREAM_STATS_QUANTILE 0.95f
+
+// P² needs five markers before it estimates anything
+#define P2_MARKERS 5
+
+// Welford running mean/variance
+typedef struct
+{
+  uint32_t count;
+  float mean;
+  float m2;
+  float min;
+  float max;
+} welford_t;
+
+void welford_reset(welford_t *p_w);
+void welford_add(welford_t *p_w, float value);
+float welford_variance(const welford_t *p_w);
+
+// Jain & Chlamtac P² single quantile estimator
+typedef struct
+{
+  float p;
+  float q[P2_MARKERS];  // Marker heights
+  int32_t n[P2_MARKERS]; // Marker positions
+  float np[P2_MARKERS];  // Desired positions
+  uint32_t count;
+} p2_t;
+
+void p2_reset(p2_t *p_p2, float p);
+void p2_add(p2_t *p_p2, float value);
+float p2_value(const p2_t *p_p2);
+
+typedef struct
+{
+  uint32_t count;
+  float mean;
+  float stddev;
+  float min;
+  float max;
+  float quantile;
+  uint32_t start; // millis() of the first sample
+  uint32_t end;   // millis() of the last sample
+} stream_stats_t;
+
+// Tumbling window of the above. Every add is a fixed amount of work.
+class StreamStats
+{
+public:
+  StreamStats(void);
+
+  // `window_ms` of 0 never closes the window. `quantile` is 0..1.
+  void setup(uint32_t window_ms, float quantile);
+  void reset();
+
+  void add(uint32_t now, float value);
+
+  // Last completed window, or the one in progress if `current`.
+  // False if it has no samples.
+  bool get(stream_stats_t *p_stats, bool current = false);
+
+private:
+  void snapshot(stream_stats_t *p_stats);
+  welford_t welford;
+  p2_t p2;
+  float quantile;
+  uint32_t window;
+  uint32_t start;
+  uint32_t end;
+  stream_stats_t last;
+};
+
+#endif //STREAM_STATS_H
@@ -0,0 +1,66 @@
+/*
+ * Project Particle Squared
+ * Description: LEB128 varint and zigzag helpers for the binary encoders
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef VARINT_H
+#define VARINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define VARINT_MAX_SIZE 5
+
+// Small magnitudes of either sign map to small unsigned values
+static inline uint32_t zigzag_encode(int32_t value)
+{
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t zigzag_decode(uint32_t value)
+{
+  return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+// Returns bytes written, 0 if it didn't fit
+static inline size_t varint_put(uint8_t *p_buf, size_t size, uint32_t value)
+{
+  size_t len = 0;
+
+  do
+  {
+    if (len >= size)
+      return 0;
+
+    uint8_t byte = value & 0x7f;
+    value >>= 7;
+
+    p_buf[len++] = value ? (byte | 0x80) : byte;
+  } while (value);
+
+  return len;
+}
+
+// Returns bytes consumed, 0 if truncated or too long
+static inline size_t varint_get(const uint8_t *p_buf, size_t len, uint32_t *p_value)
+{
+  uint32_t value = 0;
+
+  for (size_t i = 0; i < len && i < VARINT_MAX_SIZE; i++)
+  {
+    value |= (uint32_t)(p_buf[i] & 0x7f) << (7 * i);
+
+    if ((p_buf[i] & 0x80) == 0)
+    {
+      *p_value = value;
+      return i + 1;
+    }
+  }
+
+  return 0;
+}
+
+#endif //VARINT_H
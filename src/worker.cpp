@@ -0,0 +1,85 @@
+/*
+ * Project Particle Squared
+ * Description: Dedicated thread that drives the library
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include "worker.h"
+
+#if defined(PARTICLE)
+Worker::Worker(void) : running(false), thread(nullptr) {}
+#else
+Worker::Worker(void) : running(false) {}
+#endif
+
+Worker::~Worker(void)
+{
+  this->stop();
+}
+
+void Worker::run()
+{
+  while (this->running)
+  {
+    uint32_t wait = this->step();
+
+    if (wait > WORKER_MAX_WAIT_MS)
+      wait = WORKER_MAX_WAIT_MS;
+
+#if defined(PARTICLE)
+    // Always give the rest of the system a turn
+    if (wait == 0)
+      os_thread_yield();
+    else
+      delay(wait);
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(wait));
+#endif
+  }
+}
+
+bool Worker::start(const char *name, worker_step_t step, worker_prio_t priority, size_t stack_size)
+{
+  if (this->running)
+    return false;
+
+  this->step = step;
+  this->running = true;
+
+#if defined(PARTICLE)
+  this->thread = new Thread(name, [this](void) -> void
+                            { return run(); },
+                            priority, stack_size);
+#else
+  (void)name;
+  (void)priority;
+  (void)stack_size;
+  this->thread = std::thread([this]()
+                             { run(); });
+#endif
+
+  return true;
+}
+
+void Worker::stop()
+{
+  if (!this->running)
+    return;
+
+  this->running = false;
+
+#if defined(PARTICLE)
+  this->thread->join();
+  delete this->thread;
+  this->thread = nullptr;
+#else
+  this->thread.join();
+#endif
+}
+
+bool Worker::isRunning()
+{
+  return this->running;
+}
@@ -0,0 +1,58 @@
+/*
+ * Project Particle Squared
+ * Description: Dedicated thread that drives the library
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef WORKER_H
+#define WORKER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <functional>
+
+#if defined(PARTICLE)
+#include "application.h"
+typedef os_thread_prio_t worker_prio_t;
+#else
+#include <thread>
+typedef int worker_prio_t; // Ignored on the host
+#endif
+
+#define WORKER_STACK_SIZE 3072
+
+// Longest the thread sleeps between steps, so stop() stays responsive
+#define WORKER_MAX_WAIT_MS 100
+
+// One unit of work. Returns how long to sleep in ms before the next one.
+typedef std::function<uint32_t(void)> worker_step_t;
+
+// Device OS Thread on device, std::thread on the host
+class Worker
+{
+public:
+  Worker(void);
+  ~Worker(void);
+
+  bool start(const char *name, worker_step_t step, worker_prio_t priority, size_t stack_size);
+
+  // Waits for the current step to finish
+  void stop();
+
+  bool isRunning();
+
+private:
+  void run();
+  worker_step_t step;
+  std::atomic<bool> running;
+#if defined(PARTICLE)
+  Thread *thread;
+#else
+  std::thread thread;
+#endif
+};
+
+#endif //WORKER_H
@@ -0,0 +1,75 @@
+/*
+ * Project Particle Squared
+ * Description: Batch compression ratio and encode throughput on a random walk
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include "test.h"
+#include "fixtures.h"
+#include "json_writer.h"
+#include "record_codec.h"
+#include "batch_encoder.h"
+
+#define BENCH_READINGS 1000
+#define BENCH_ROUNDS 200
+
+static AirQualityWingData_t readings[BENCH_READINGS];
+
+int main()
+{
+  uint32_t seed = 1;
+  size_t json_bytes = 0, record_bytes = 0;
+  char json[JSON_MAX_SIZE];
+  uint8_t record[RECORD_MAX_SIZE];
+
+  readings[0] = fixture_reading(0);
+  for (uint32_t i = 1; i < BENCH_READINGS; i++)
+    readings[i] = fixture_walk(&readings[i - 1], &seed);
+
+  for (uint32_t i = 0; i < BENCH_READINGS; i++)
+  {
+    json_bytes += json_write(&readings[i], JSON_FIELD_ALL, json, sizeof(json));
+    record_bytes += record_encode(&readings[i], record, sizeof(record));
+  }
+
+  // Back to back publish sized batches, like an uplink would send them
+  uint8_t buf[BATCH_MAX_SIZE];
+  BatchEncoder encoder;
+  size_t batch_bytes = 0;
+  uint32_t batches = 0, acc = 0;
+
+  uint64_t start = test_now_ns();
+  for (uint32_t round = 0; round < BENCH_ROUNDS; round++)
+  {
+    uint32_t i = 0;
+
+    while (i < BENCH_READINGS)
+    {
+      encoder.begin(buf, sizeof(buf));
+
+      while (i < BENCH_READINGS && encoder.add(1700000000 + i * 120, &readings[i]))
+        i++;
+
+      size_t len = encoder.finish();
+      acc += len;
+
+      if (round == 0)
+      {
+        batch_bytes += len;
+        batches++;
+      }
+    }
+  }
+  uint64_t encode_ns = test_now_ns() - start;
+
+  bench_sink = acc;
+
+  printf("batch %.1f bytes/reading (json %.1f, record %.1f), %.1f readings/publish, %.1f ns/reading\n",
+         (double)batch_bytes / BENCH_READINGS, (double)json_bytes / BENCH_READINGS,
+         (double)record_bytes / BENCH_READINGS, (double)BENCH_READINGS / batches,
+         (double)encode_ns / BENCH_ROUNDS / BENCH_READINGS);
+
+  return 0;
+}
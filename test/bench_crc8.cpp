@@ -0,0 +1,46 @@
+/*
+ * Project Particle Squared
+ * Description: Table CRC8 against the bitwise routine
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include "test.h"
+#include "reference.h"
+#include "crc8_dallas.h"
+
+#define BENCH_ROUNDS 64
+
+int main()
+{
+  uint32_t acc = 0;
+  uint8_t word[2];
+
+  uint64_t start = test_now_ns();
+  for (uint32_t round = 0; round < BENCH_ROUNDS; round++)
+    for (uint32_t value = 0; value <= 0xffff; value++)
+    {
+      word[0] = value;
+      word[1] = (value >> 8) ^ round;
+      acc += ref_crc8_dallas_little(word, 2);
+    }
+  uint64_t bitwise = test_now_ns() - start;
+
+  start = test_now_ns();
+  for (uint32_t round = 0; round < BENCH_ROUNDS; round++)
+    for (uint32_t value = 0; value <= 0xffff; value++)
+    {
+      word[0] = value;
+      word[1] = (value >> 8) ^ round;
+      acc += crc8_dallas_little(word, 2);
+    }
+  uint64_t table = test_now_ns() - start;
+
+  bench_sink = acc;
+
+  double words = (double)BENCH_ROUNDS * 65536;
+  printf("crc8 bitwise %.2f ns/word, table %.2f ns/word\n", bitwise / words, table / words);
+
+  return 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * Project Particle Squared
+ * Description: JSON writer against the old toString(), time and heap use
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include <stdlib.h>
+#include <new>
+
+#include "test.h"
+#include "reference.h"
+#include "fixtures.h"
+#include "json_writer.h"
+
+#define BENCH_CALLS 100000
+
+static uint32_t allocations;
+
+void *operator new(size_t size)
+{
+  allocations++;
+
+  void *p = malloc(size);
+  if (p == nullptr)
+    throw std::bad_alloc();
+
+  return p;
+}
+
+void operator delete(void *p) noexcept
+{
+  free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+  free(p);
+}
+
+int main()
+{
+  uint32_t acc = 0;
+  char buf[JSON_MAX_SIZE];
+
+  allocations = 0;
+  uint64_t start = test_now_ns();
+  for (uint32_t i = 0; i < BENCH_CALLS; i++)
+  {
+    AirQualityWingData_t data = fixture_reading(i);
+    acc += ref_to_string(&data).size();
+  }
+  uint64_t old_ns = test_now_ns() - start;
+  uint32_t old_allocations = allocations;
+  uint32_t old_bytes = acc;
+
+  allocations = 0;
+  acc = 0;
+  start = test_now_ns();
+  for (uint32_t i = 0; i < BENCH_CALLS; i++)
+  {
+    AirQualityWingData_t data = fixture_reading(i);
+    acc += json_write(&data, JSON_FIELD_ALL, buf, sizeof(buf));
+  }
+  uint64_t new_ns = test_now_ns() - start;
+
+  bench_sink = acc;
+
+  printf("json toString %u bytes, %.1f allocations, %.3f us per call\n",
+         old_bytes / BENCH_CALLS, (double)old_allocations / BENCH_CALLS, old_ns / 1000.0 / BENCH_CALLS);
+  printf("json writer   %u bytes, %.1f allocations, %.3f us per call\n",
+         acc / BENCH_CALLS, (double)allocations / BENCH_CALLS, new_ns / 1000.0 / BENCH_CALLS);
+
+  return 0;
+}
@@ -0,0 +1,48 @@
+/*
+ * Project Particle Squared
+ * Description: Record codec size against JSON, encode and decode time
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include "test.h"
+#include "fixtures.h"
+#include "json_writer.h"
+#include "record_codec.h"
+
+#define BENCH_CALLS 1000000
+
+int main()
+{
+  uint8_t buf[RECORD_MAX_SIZE];
+  char json[JSON_MAX_SIZE];
+  AirQualityWingData_t data = fixture_reading(0), decoded;
+
+  size_t record_len = record_encode(&data, buf, sizeof(buf));
+  size_t json_len = json_write(&data, JSON_FIELD_ALL, json, sizeof(json));
+
+  uint32_t acc = 0;
+  uint64_t start = test_now_ns();
+  for (uint32_t i = 0; i < BENCH_CALLS; i++)
+  {
+    data.sgp40.data.tvoc = i & 0xff;
+    acc += record_encode(&data, buf, sizeof(buf));
+  }
+  uint64_t encode_ns = test_now_ns() - start;
+
+  start = test_now_ns();
+  for (uint32_t i = 0; i < BENCH_CALLS; i++)
+  {
+    buf[2] = i & 0x7f;
+    acc += record_decode(buf, record_len, &decoded, nullptr) + decoded.hpma115.data.pm25;
+  }
+  uint64_t decode_ns = test_now_ns() - start;
+
+  bench_sink = acc;
+
+  printf("record %u bytes vs %u bytes of JSON, encode %.1f ns, decode %.1f ns\n",
+         (unsigned)record_len, (unsigned)json_len, (double)encode_ns / BENCH_CALLS, (double)decode_ns / BENCH_CALLS);
+
+  return 0;
+}
@@ -0,0 +1,77 @@
+/*
+ * Project Particle Squared
+ * Description: Readings shared by the host tests and benchmarks
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef FIXTURES_H
+#define FIXTURES_H
+
+#include <stdint.h>
+
+#include "aqw_data.h"
+
+// A full reading with typical indoor values
+static inline AirQualityWingData_t fixture_reading(uint32_t i)
+{
+  AirQualityWingData_t data = {};
+
+  data.hpma115.hasData = true;
+  data.hpma115.data.pm25 = 8 + i % 7;
+  data.hpma115.data.pm10 = 12 + i % 9;
+  data.shtc3.hasData = true;
+  data.shtc3.data.temperature = 2150 + (int16_t)(i % 40) - 20;
+  data.shtc3.data.humidity = 4200 + i % 150;
+  data.sgp40.hasData = true;
+  data.sgp40.data.tvoc = 100 + i % 30;
+
+  return data;
+}
+
+// Random walk around fixture_reading(0), as a room drifts between cycles
+static inline AirQualityWingData_t fixture_walk(const AirQualityWingData_t *p_prev, uint32_t *p_seed)
+{
+  AirQualityWingData_t data = *p_prev;
+  int32_t step[5];
+
+  for (uint8_t i = 0; i < 5; i++)
+  {
+    *p_seed = *p_seed * 1103515245 + 12345;
+    step[i] = (int32_t)((*p_seed >> 16) % 5) - 2;
+  }
+
+  if (data.hpma115.data.pm25 + step[0] >= 0)
+    data.hpma115.data.pm25 += step[0];
+  if (data.hpma115.data.pm10 + step[1] >= 0)
+    data.hpma115.data.pm10 += step[1];
+  data.shtc3.data.temperature += step[2] * 3;
+  data.shtc3.data.humidity += step[3] * 7;
+  data.sgp40.data.tvoc += step[4];
+
+  return data;
+}
+
+// Same channels present with the same values. Raw words and the AQI aren't compared.
+static inline bool fixture_equal(const AirQualityWingData_t *p_a, const AirQualityWingData_t *p_b)
+{
+  if (p_a->hpma115.hasData != p_b->hpma115.hasData || p_a->shtc3.hasData != p_b->shtc3.hasData ||
+      p_a->sgp40.hasData != p_b->sgp40.hasData)
+    return false;
+
+  if (p_a->hpma115.hasData && (p_a->hpma115.data.pm25 != p_b->hpma115.data.pm25 ||
+                               p_a->hpma115.data.pm10 != p_b->hpma115.data.pm10))
+    return false;
+
+  if (p_a->shtc3.hasData && (p_a->shtc3.data.temperature != p_b->shtc3.data.temperature ||
+                             p_a->shtc3.data.humidity != p_b->shtc3.data.humidity))
+    return false;
+
+  if (p_a->sgp40.hasData && p_a->sgp40.data.tvoc != p_b->sgp40.data.tvoc)
+    return false;
+
+  return true;
+}
+
+#endif //FIXTURES_H
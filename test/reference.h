@@ -0,0 +1,69 @@
+/*
+ * Project Particle Squared
+ * Description: Earlier implementations, kept to check and benchmark the current ones against
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef REFERENCE_H
+#define REFERENCE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+#include "aqw_data.h"
+
+// Bit-serial CRC8 the table driven version replaced
+static inline uint8_t ref_crc8_dallas_little(const uint8_t *data, uint16_t size)
+{
+  uint8_t crc = 0xff;
+
+  while (size--)
+  {
+    crc ^= data[size];
+
+    for (int i = 0; i < 8; i++)
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+  }
+
+  return crc;
+}
+
+// toString() before the JSON writer. std::string stands in for String,
+// with the same chain of temporaries.
+static inline std::string ref_to_string(const AirQualityWingData_t *p_data)
+{
+  std::string out = "{";
+  char buf[64];
+
+  if (p_data->hpma115.hasData)
+  {
+    snprintf(buf, sizeof(buf), "\"pm25\":%d,\"pm10\":%d", p_data->hpma115.data.pm25, p_data->hpma115.data.pm10);
+    out = std::string(out + std::string(buf));
+  }
+
+  if (p_data->shtc3.hasData)
+  {
+    if (p_data->hpma115.hasData)
+      out = std::string(out + ",");
+
+    snprintf(buf, sizeof(buf), "\"temperature\":%.2f,\"humidity\":%.2f",
+             p_data->shtc3.data.temperature / 100.0, p_data->shtc3.data.humidity / 100.0);
+    out = std::string(out + std::string(buf));
+  }
+
+  if (p_data->sgp40.hasData)
+  {
+    if (p_data->hpma115.hasData || p_data->shtc3.hasData)
+      out = std::string(out + ",");
+
+    snprintf(buf, sizeof(buf), "\"tvoc\":%d", (int)p_data->sgp40.data.tvoc);
+    out = std::string(out + std::string(buf));
+  }
+
+  return std::string(out + "}");
+}
+
+#endif //REFERENCE_H
@@ -0,0 +1,57 @@
+/*
+ * Project Particle Squared
+ * Description: Minimal helpers for the host tests and benchmarks
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <chrono>
+
+static int test_failures = 0;
+
+#define CHECK(cond)                                                   \
+  do                                                                  \
+  {                                                                   \
+    if (!(cond))                                                      \
+    {                                                                 \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      test_failures++;                                                \
+    }                                                                 \
+  } while (0)
+
+#define CHECK_EQ(a, b)                                                  \
+  do                                                                    \
+  {                                                                     \
+    long long _a = (long long)(a), _b = (long long)(b);                 \
+    if (_a != _b)                                                       \
+    {                                                                   \
+      printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n",          \
+             __FILE__, __LINE__, #a, #b, _a, _b);                       \
+      test_failures++;                                                  \
+    }                                                                   \
+  } while (0)
+
+// Exit code for main()
+static inline int test_result(const char *name)
+{
+  printf("%s: %s\n", name, test_failures ? "FAILED" : "ok");
+  return test_failures ? 1 : 0;
+}
+
+static inline uint64_t test_now_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Keeps the optimizer from dropping benchmarked work
+static volatile uint32_t bench_sink;
+
+#endif //TEST_H
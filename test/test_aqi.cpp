@@ -0,0 +1,145 @@
+/*
+ * Project Particle Squared
+ * Description: AQI breakpoints and NowCast against worked EPA examples
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include "test.h"
+#include "aqi.h"
+
+// On an hour boundary
+#define TEST_T0 (1700000000 / AQI_HOUR_S * AQI_HOUR_S)
+
+// One PM2.5 reading per hour, `hours[0]` the most recent. PM10 follows along.
+static void feed(AQI *p_aqi, const uint16_t *p_hours, uint8_t count)
+{
+  for (uint8_t i = 0; i < count; i++)
+  {
+    uint16_t pm = p_hours[count - 1 - i];
+    p_aqi->add(TEST_T0 + i * AQI_HOUR_S, pm, pm);
+  }
+}
+
+static void test_index()
+{
+  // Technical Assistance Document example: PM2.5 of 35.9 µg/m³ is 102
+  CHECK_EQ(aqi_index(AQI_PM25, 359), 102);
+
+  // 2024 PM2.5 breakpoint edges
+  CHECK_EQ(aqi_index(AQI_PM25, 0), 0);
+  CHECK_EQ(aqi_index(AQI_PM25, 90), 50);
+  CHECK_EQ(aqi_index(AQI_PM25, 91), 51);
+  CHECK_EQ(aqi_index(AQI_PM25, 354), 100);
+  CHECK_EQ(aqi_index(AQI_PM25, 355), 101);
+  CHECK_EQ(aqi_index(AQI_PM25, 554), 150);
+  CHECK_EQ(aqi_index(AQI_PM25, 555), 151);
+  CHECK_EQ(aqi_index(AQI_PM25, 1254), 200);
+  CHECK_EQ(aqi_index(AQI_PM25, 1255), 201);
+  CHECK_EQ(aqi_index(AQI_PM25, 2254), 300);
+  CHECK_EQ(aqi_index(AQI_PM25, 2255), 301);
+  CHECK_EQ(aqi_index(AQI_PM25, 3254), 500);
+  CHECK_EQ(aqi_index(AQI_PM25, 5000), 500);
+
+  // PM10 edges
+  CHECK_EQ(aqi_index(AQI_PM10, 54), 50);
+  CHECK_EQ(aqi_index(AQI_PM10, 55), 51);
+  CHECK_EQ(aqi_index(AQI_PM10, 154), 100);
+  CHECK_EQ(aqi_index(AQI_PM10, 155), 101);
+  CHECK_EQ(aqi_index(AQI_PM10, 604), 500);
+}
+
+static void test_nowcast()
+{
+  AQI aqi;
+  aqi_data_t data;
+
+  // Fast changing hours: w = 10/90 is clamped to 0.5, so the NowCast is
+  // sum(0.5^i * c[i]) / sum(0.5^i) = 17.41, truncated to 17.4 and AQI 66
+  const uint16_t fast[] = {13, 16, 10, 21, 74, 64, 53, 82, 90, 75, 80, 50};
+
+  // The first reading of the next hour closes the latest one
+  feed(&aqi, fast, 12);
+  aqi.add(TEST_T0 + 12 * AQI_HOUR_S, 0, 0);
+  CHECK(aqi.get(&data));
+  CHECK_EQ(data.pm25_nowcast, 174);
+  CHECK_EQ(data.pm10_nowcast, 17);
+  CHECK_EQ(data.pm25_aqi, 66);
+  CHECK_EQ(data.aqi, 66);
+
+  // The partial hour doesn't move it, however large
+  aqi.add(TEST_T0 + 12 * AQI_HOUR_S + 60, 500, 500);
+  CHECK(aqi.get(&data));
+  CHECK_EQ(data.pm25_nowcast, 174);
+
+  // Steady hours: w = 10/13 = 0.769, NowCast 11.05
+  const uint16_t steady[] = {12, 11, 11, 10, 10, 10, 10, 11, 12, 13, 13, 12};
+
+  aqi.reset();
+  feed(&aqi, steady, 12);
+  aqi.add(TEST_T0 + 12 * AQI_HOUR_S, 0, 0);
+  CHECK(aqi.get(&data));
+  CHECK_EQ(data.pm25_nowcast, 110);
+  CHECK_EQ(data.pm25_aqi, 51 + (49 * (110 - 91) * 2 / 263 + 1) / 2);
+}
+
+static void test_missing_hours()
+{
+  AQI aqi;
+  aqi_data_t data;
+
+  // Two of the three latest completed hours are required
+  aqi.add(TEST_T0, 20, 20);
+  aqi.add(TEST_T0 + 3 * AQI_HOUR_S, 20, 20);
+  CHECK(aqi.get(&data) == false);
+
+  aqi.add(TEST_T0 + 4 * AQI_HOUR_S, 20, 20);
+  CHECK(aqi.get(&data) == false);
+
+  aqi.add(TEST_T0 + 5 * AQI_HOUR_S, 20, 20);
+  CHECK(aqi.get(&data));
+  CHECK_EQ(data.pm25_nowcast, 200);
+
+  // Daily average needs 18 of the 24 hours
+  CHECK_EQ(data.pm25_24h, AQI_INVALID);
+}
+
+static void test_state()
+{
+  AQI aqi, restored;
+  aqi_data_t before, after;
+  aqi_state_t state;
+
+  // Uneven hours so the averages carry tenths
+  for (uint32_t t = 0; t < 20 * AQI_HOUR_S; t += 600)
+    aqi.add(TEST_T0 + t, 5 + (t / 600) % 7, 20 + (t / 3600));
+
+  aqi.getState(&state);
+  restored.setState(&state);
+
+  CHECK(aqi.get(&before));
+  CHECK(restored.get(&after));
+  CHECK_EQ(after.pm25_nowcast, before.pm25_nowcast);
+  CHECK_EQ(after.pm10_nowcast, before.pm10_nowcast);
+  CHECK_EQ(after.pm25_24h, before.pm25_24h);
+  CHECK_EQ(after.pm10_24h, before.pm10_24h);
+  CHECK_EQ(after.aqi, before.aqi);
+
+  // And it carries on from there
+  aqi.add(TEST_T0 + 21 * AQI_HOUR_S, 40, 40);
+  restored.add(TEST_T0 + 21 * AQI_HOUR_S, 40, 40);
+  aqi.get(&before);
+  restored.get(&after);
+  CHECK_EQ(after.pm25_nowcast, before.pm25_nowcast);
+}
+
+int main()
+{
+  test_index();
+  test_nowcast();
+  test_missing_hours();
+  test_state();
+
+  return test_result("aqi");
+}
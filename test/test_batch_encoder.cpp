@@ -0,0 +1,190 @@
+/*
+ * Project Particle Squared
+ * Description: Batch encoder round trips, edge values and limits
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include <string.h>
+
+#include "test.h"
+#include "fixtures.h"
+#include "batch_encoder.h"
+
+#define TEST_MAX_READINGS BATCH_MAX_READINGS
+
+typedef struct
+{
+  uint32_t timestamps[TEST_MAX_READINGS];
+  AirQualityWingData_t readings[TEST_MAX_READINGS];
+  uint16_t count;
+  uint16_t mismatches;
+} expected_t;
+
+static void compare(uint32_t timestamp, const AirQualityWingData_t *p_data, void *p_context)
+{
+  expected_t *p_expected = (expected_t *)p_context;
+  uint16_t n = p_expected->count++;
+
+  if (n >= TEST_MAX_READINGS || p_expected->timestamps[n] != timestamp ||
+      !fixture_equal(&p_expected->readings[n], p_data))
+    p_expected->mismatches++;
+}
+
+// Encodes everything in `p_expected`, decodes it and compares
+static bool round_trip(expected_t *p_expected, uint16_t count)
+{
+  uint8_t buf[BATCH_MAX_SIZE * 4];
+  BatchEncoder encoder;
+
+  encoder.begin(buf, sizeof(buf));
+
+  for (uint16_t i = 0; i < count; i++)
+    if (!encoder.add(p_expected->timestamps[i], &p_expected->readings[i]))
+      return false;
+
+  size_t len = encoder.finish();
+
+  p_expected->count = 0;
+  p_expected->mismatches = 0;
+
+  return batch_decode(buf, len, compare, p_expected) == BATCH_SUCCESS &&
+         p_expected->count == count && p_expected->mismatches == 0;
+}
+
+static expected_t expected;
+
+static void test_walk()
+{
+  uint32_t seed = 1;
+
+  expected.timestamps[0] = 1700000000;
+  expected.readings[0] = fixture_reading(0);
+
+  // Jittery interval, sensors dropping in and out
+  for (uint16_t i = 1; i < 100; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    expected.timestamps[i] = expected.timestamps[i - 1] + 120 + (seed >> 16) % 7 - 3;
+    expected.readings[i] = fixture_walk(&expected.readings[i - 1], &seed);
+    expected.readings[i].hpma115.hasData = (i % 5) != 0;
+    expected.readings[i].sgp40.hasData = (i % 7) != 0;
+  }
+
+  CHECK(round_trip(&expected, 100));
+}
+
+static void test_edges()
+{
+  AirQualityWingData_t low = {}, high = {}, none = {};
+
+  low.hpma115.hasData = low.shtc3.hasData = low.sgp40.hasData = true;
+  low.shtc3.data.temperature = INT16_MIN;
+  low.sgp40.data.tvoc = INT32_MIN;
+
+  high.hpma115.hasData = high.shtc3.hasData = high.sgp40.hasData = true;
+  high.hpma115.data.pm25 = high.hpma115.data.pm10 = 65535;
+  high.shtc3.data.temperature = INT16_MAX;
+  high.shtc3.data.humidity = 65535;
+  high.sgp40.data.tvoc = INT32_MAX;
+
+  // Swings from one end to the other, timestamps that go backwards
+  // and an empty presence bitmap in between
+  const uint32_t timestamps[] = {0, 0xffffffff, 5, 5, 0x80000000, 1};
+  const AirQualityWingData_t *readings[] = {&low, &high, &none, &low, &high, &none};
+
+  for (uint8_t i = 0; i < 6; i++)
+  {
+    expected.timestamps[i] = timestamps[i];
+    expected.readings[i] = *readings[i];
+  }
+
+  CHECK(round_trip(&expected, 6));
+
+  // A batch of nothing
+  uint8_t buf[BATCH_HEADER_SIZE];
+  BatchEncoder encoder;
+  encoder.begin(buf, sizeof(buf));
+  CHECK_EQ(encoder.finish(), BATCH_HEADER_SIZE);
+  expected.count = 0;
+  CHECK_EQ(batch_decode(buf, BATCH_HEADER_SIZE, compare, &expected), BATCH_SUCCESS);
+  CHECK_EQ(expected.count, 0);
+}
+
+static void test_full()
+{
+  uint8_t buf[BATCH_MAX_SIZE];
+  char text[BATCH_PUBLISH_DATA_LENGTH + 1];
+  BatchEncoder encoder;
+  uint32_t seed = 7;
+  uint16_t count = 0;
+
+  encoder.begin(buf, sizeof(buf));
+  expected.readings[0] = fixture_reading(0);
+
+  // Fills up, the reading that didn't fit leaves the batch intact
+  while (count < TEST_MAX_READINGS)
+  {
+    expected.timestamps[count] = 1700000000 + count * 120;
+    if (count > 0)
+      expected.readings[count] = fixture_walk(&expected.readings[count - 1], &seed);
+
+    // Big jumps so the buffer runs out before the reading count does
+    expected.readings[count].sgp40.data.tvoc += (count % 2) ? 100000 : -100000;
+
+    if (!encoder.add(expected.timestamps[count], &expected.readings[count]))
+      break;
+
+    count++;
+  }
+
+  CHECK(count > 0 && count < TEST_MAX_READINGS);
+  CHECK_EQ(encoder.count(), count);
+
+  size_t len = encoder.finish();
+  CHECK(len <= BATCH_MAX_SIZE);
+
+  expected.count = 0;
+  expected.mismatches = 0;
+  CHECK_EQ(batch_decode(buf, len, compare, &expected), BATCH_SUCCESS);
+  CHECK_EQ(expected.count, count);
+  CHECK_EQ(expected.mismatches, 0);
+
+  // Full batch still fits a publish
+  size_t text_len = batch_base64(buf, len, text, sizeof(text));
+  CHECK(text_len > 0 && text_len <= BATCH_PUBLISH_DATA_LENGTH);
+
+  // Cut short anywhere past the header
+  for (size_t i = BATCH_HEADER_SIZE; i < len - 1; i += 7)
+  {
+    expected.count = 0;
+    CHECK_EQ(batch_decode(buf, i, compare, &expected), BATCH_TRUNCATED);
+  }
+
+  buf[0] = BATCH_VERSION + 1;
+  CHECK_EQ(batch_decode(buf, len, compare, &expected), BATCH_BAD_VERSION);
+}
+
+static void test_base64()
+{
+  char text[8];
+
+  CHECK_EQ(batch_base64((const uint8_t *)"Man", 3, text, sizeof(text)), 4);
+  CHECK(strcmp(text, "TWFu") == 0);
+  CHECK_EQ(batch_base64((const uint8_t *)"Ma", 2, text, sizeof(text)), 4);
+  CHECK(strcmp(text, "TWE=") == 0);
+  CHECK_EQ(batch_base64((const uint8_t *)"M", 1, text, sizeof(text)), 4);
+  CHECK(strcmp(text, "TQ==") == 0);
+  CHECK_EQ(batch_base64((const uint8_t *)"Man", 3, text, 4), 0);
+}
+
+int main()
+{
+  test_walk();
+  test_edges();
+  test_full();
+  test_base64();
+
+  return test_result("batch_encoder");
+}
@@ -0,0 +1,60 @@
+/*
+ * Project Particle Squared
+ * Description: CRC8 table against the bitwise routine, all 16-bit inputs
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include "test.h"
+#include "reference.h"
+#include "crc8_dallas.h"
+
+int main()
+{
+  uint32_t mismatches = 0;
+
+  for (uint32_t value = 0; value <= 0xffff; value++)
+  {
+    // Little endian in memory, as the drivers used to pass it
+    uint8_t little[2] = {(uint8_t)(value & 0xff), (uint8_t)(value >> 8)};
+    uint8_t wire[2] = {(uint8_t)(value >> 8), (uint8_t)(value & 0xff)};
+    uint8_t expected = ref_crc8_dallas_little(little, 2);
+
+    if (crc8_dallas_little(little, 2) != expected || crc8_dallas(wire, 2) != expected)
+      mismatches++;
+
+    // Word helpers agree with the same CRC
+    uint16_t word = value, unpacked = 0;
+    uint8_t packed[CRC8_WORD_SIZE];
+
+    crc8_append_words(&word, 1, packed);
+    if (packed[2] != expected || crc8_unpack_words(packed, 1, &unpacked) != CRC8_SUCCESS || unpacked != word)
+      mismatches++;
+
+    packed[2] ^= 0x01;
+    if (crc8_check_words(packed, 1) != CRC8_MISMATCH)
+      mismatches++;
+  }
+
+  CHECK_EQ(mismatches, 0);
+
+  // Datasheet example
+  uint8_t beef[] = {0xBE, 0xEF, 0x92};
+  CHECK_EQ(crc8_check_words(beef, 1), CRC8_SUCCESS);
+
+  // A bad word anywhere fails the batch and leaves the output alone
+  uint16_t words[3] = {0x1234, 0xBEEF, 0x0000}, out[3] = {0, 0, 0};
+  uint8_t buf[3 * CRC8_WORD_SIZE];
+
+  crc8_append_words(words, 3, buf);
+  CHECK_EQ(crc8_unpack_words(buf, 3, out), CRC8_SUCCESS);
+  CHECK_EQ(out[1], 0xBEEF);
+
+  buf[8] ^= 0x80;
+  out[0] = 0;
+  CHECK_EQ(crc8_unpack_words(buf, 3, out), CRC8_MISMATCH);
+  CHECK_EQ(out[0], 0);
+
+  return test_result("crc8");
+}
@@ -0,0 +1,167 @@
+/*
+ * Project Particle Squared
+ * Description: Report by exception thresholds, heartbeat and counters
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include "test.h"
+#include "fixtures.h"
+#include "deadband.h"
+
+static void test_threshold()
+{
+  Deadband deadband;
+  AirQualityWingData_t data = fixture_reading(0);
+
+  // 0.5 °C, 2 µg/m³, the rest never on their own
+  for (uint8_t i = 0; i < AQW_CHANNEL_COUNT; i++)
+    deadband.setThreshold(i, DEADBAND_IGNORE);
+  deadband.setThreshold(AQW_CHANNEL_TEMPERATURE, 50);
+  deadband.setThreshold(AQW_CHANNEL_PM25, 2);
+
+  // First reading always goes out
+  CHECK(deadband.check(0, &data));
+  CHECK(!deadband.check(1000, &data));
+
+  // Under the threshold, and measured from the last report, not the last reading
+  data.shtc3.data.temperature += 30;
+  CHECK(!deadband.check(2000, &data));
+  data.shtc3.data.temperature += 19;
+  CHECK(!deadband.check(3000, &data));
+  data.shtc3.data.temperature += 1;
+  CHECK(deadband.check(4000, &data));
+
+  // Either direction
+  data.shtc3.data.temperature -= 50;
+  CHECK(deadband.check(5000, &data));
+
+  data.hpma115.data.pm25 += 1;
+  CHECK(!deadband.check(6000, &data));
+  data.hpma115.data.pm25 -= 3;
+  CHECK(deadband.check(7000, &data));
+
+  // Ignored channels can move as much as they like
+  data.sgp40.data.tvoc += 400;
+  data.shtc3.data.humidity -= 3000;
+  CHECK(!deadband.check(8000, &data));
+
+  // A channel appearing or going away is news
+  data.sgp40.hasData = false;
+  CHECK(deadband.check(9000, &data));
+  CHECK(!deadband.check(10000, &data));
+  data.sgp40.hasData = true;
+  CHECK(deadband.check(11000, &data));
+
+  // 0 reports every reading
+  deadband.setThreshold(AQW_CHANNEL_HUMIDITY, 0);
+  CHECK(deadband.check(12000, &data));
+  CHECK(deadband.check(13000, &data));
+
+  // Forgotten on reset
+  deadband.setThreshold(AQW_CHANNEL_HUMIDITY, DEADBAND_IGNORE);
+  CHECK(!deadband.check(14000, &data));
+  deadband.reset();
+  CHECK(deadband.check(15000, &data));
+}
+
+static void test_heartbeat()
+{
+  Deadband deadband;
+  AirQualityWingData_t data = fixture_reading(0);
+
+  for (uint8_t i = 0; i < AQW_CHANNEL_COUNT; i++)
+    deadband.setThreshold(i, DEADBAND_IGNORE);
+  deadband.setHeartbeat(60000);
+
+  // Across a millis() wrap
+  uint32_t start = 0xffff0000;
+
+  CHECK(deadband.check(start, &data));
+  CHECK(!deadband.check(start + 59999, &data));
+  CHECK(deadband.check(start + 60000, &data));
+
+  // Measured from the last report, whatever sent it
+  deadband.setThreshold(AQW_CHANNEL_PM25, 1);
+  data.hpma115.data.pm25 += 5;
+  CHECK(deadband.check(start + 90000, &data));
+  CHECK(!deadband.check(start + 149999, &data));
+  CHECK(deadband.check(start + 150000, &data));
+
+  // 0 never forces one
+  deadband.setHeartbeat(0);
+  CHECK(!deadband.check(start + 10000000, &data));
+}
+
+static void test_counters()
+{
+  Deadband deadband;
+  AirQualityWingData_t data = fixture_reading(0);
+
+  for (uint8_t i = 0; i < AQW_CHANNEL_COUNT; i++)
+    deadband.setThreshold(i, 10);
+  deadband.setHeartbeat(1000);
+
+  deadband.check(0, &data);    // First
+  deadband.check(100, &data);  // Suppressed
+  deadband.check(200, &data);  // Suppressed
+  deadband.check(1000, &data); // Heartbeat
+
+  data.hpma115.data.pm10 += 10;
+  deadband.check(1100, &data); // Threshold, not a heartbeat
+  deadband.check(2100, &data); // Heartbeat
+
+  deadband_stats_t stats = deadband.getStats(true);
+  CHECK_EQ(stats.emitted, 4);
+  CHECK_EQ(stats.suppressed, 2);
+  CHECK_EQ(stats.heartbeats, 2);
+
+  stats = deadband.getStats(false);
+  CHECK_EQ(stats.emitted, 0);
+  CHECK_EQ(stats.suppressed, 0);
+  CHECK_EQ(stats.heartbeats, 0);
+
+  // Counters survive a filter reset
+  deadband.check(2200, &data);
+  deadband.reset();
+  deadband.check(2300, &data);
+  stats = deadband.getStats(false);
+  CHECK_EQ(stats.emitted, 1);
+  CHECK_EQ(stats.suppressed, 1);
+}
+
+static void test_state()
+{
+  Deadband deadband, restored;
+  AirQualityWingData_t data = fixture_reading(0);
+  deadband_state_t state;
+
+  deadband.setThreshold(AQW_CHANNEL_TVOC, 5);
+  restored.setThreshold(AQW_CHANNEL_TVOC, 5);
+  for (uint8_t i = 0; i < AQW_CHANNEL_TVOC; i++)
+  {
+    deadband.setThreshold(i, DEADBAND_IGNORE);
+    restored.setThreshold(i, DEADBAND_IGNORE);
+  }
+
+  deadband.check(1000, &data);
+  deadband.getState(&state);
+  restored.setState(&state);
+
+  // Picks up from the same baseline instead of reporting again
+  data.sgp40.data.tvoc += 4;
+  CHECK(!restored.check(2000, &data));
+  data.sgp40.data.tvoc += 1;
+  CHECK(restored.check(3000, &data));
+}
+
+int main()
+{
+  test_threshold();
+  test_heartbeat();
+  test_counters();
+  test_state();
+
+  return test_result("deadband");
+}
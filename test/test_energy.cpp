@@ -0,0 +1,238 @@
+/*
+ * Project Particle Squared
+ * Description: Energy accounting and budget plans against a simulated clock
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include <math.h>
+
+#include "test.h"
+#include "energy.h"
+
+#define TEST_INTERVAL 60000
+#define TEST_MAX_INTERVAL 3600000
+
+static uint32_t test_ms;
+
+static uint32_t test_clock(void)
+{
+  return test_ms;
+}
+
+// HPMA115 only, 36 mA for round numbers: 10 s on is 100 µAh
+static void setup_meter(EnergyMeter *p_meter)
+{
+  test_ms = 5000;
+  p_meter->setClock(test_clock);
+
+  for (uint8_t i = 0; i < ENERGY_COMPONENT_COUNT; i++)
+    p_meter->setCurrent(i, 0);
+  p_meter->setCurrent(ENERGY_HPMA115, 36000);
+}
+
+// `count` cycles of `interval` ms with the HPMA115 on for the first `on_ms`
+static void run_cycles(EnergyMeter *p_meter, uint32_t count, uint32_t on_ms, uint32_t interval)
+{
+  for (uint32_t i = 0; i < count; i++)
+  {
+    p_meter->start(ENERGY_HPMA115);
+    test_ms += on_ms;
+    p_meter->stop(ENERGY_HPMA115);
+    test_ms += interval - on_ms;
+    p_meter->cycle();
+  }
+}
+
+// What plan() should come up with after `cycles` of `per_cycle` µAh
+static uint32_t expected_interval(uint32_t budget, uint32_t cycles, float per_cycle, uint32_t elapsed)
+{
+  float left = budget - cycles * per_cycle;
+  return (uint32_t)((ENERGY_DAY_MS - elapsed) / (left / per_cycle));
+}
+
+static void test_accumulation()
+{
+  EnergyMeter meter;
+
+  test_ms = 1000;
+  meter.setClock(test_clock);
+
+  // Repeated starts and stops are ignored
+  meter.start(ENERGY_HPMA115);
+  test_ms += 2000;
+  meter.start(ENERGY_HPMA115);
+  test_ms += 3000;
+  meter.stop(ENERGY_HPMA115);
+  meter.stop(ENERGY_HPMA115);
+
+  // Measured elsewhere
+  meter.add(ENERGY_SHTC3, 12100);
+  meter.add(ENERGY_SHTC3, 12100);
+  meter.add(ENERGY_COMPONENT_COUNT, 1000);
+
+  // Still running counts up to now
+  meter.start(ENERGY_SGP40);
+  test_ms += 500;
+
+  energy_report_t report = meter.getReport(true);
+  CHECK_EQ(report.on_ms[ENERGY_HPMA115], 5000);
+  CHECK_EQ(report.on_ms[ENERGY_SHTC3], 24);
+  CHECK_EQ(report.on_ms[ENERGY_SGP40], 500);
+  CHECK_EQ(report.on_ms[ENERGY_I2C], 0);
+  CHECK_EQ(report.window_ms, 5500);
+
+  // Reset, the SGP40 carries on from here
+  test_ms += 250;
+  meter.stop(ENERGY_SGP40);
+  report = meter.getReport(false);
+  CHECK_EQ(report.on_ms[ENERGY_HPMA115], 0);
+  CHECK_EQ(report.on_ms[ENERGY_SGP40], 250);
+  CHECK_EQ(report.window_ms, 250);
+}
+
+static void test_charge()
+{
+  EnergyMeter meter;
+  setup_meter(&meter);
+
+  meter.setCurrent(ENERGY_SGP40, 3600);
+  meter.setCurrent(ENERGY_I2C, 1000);
+
+  // 36 mA for 10 s, 3.6 mA for 1 s, 1 mA for 36 ms
+  meter.start(ENERGY_HPMA115);
+  test_ms += 10000;
+  meter.stop(ENERGY_HPMA115);
+  meter.add(ENERGY_SGP40, 1000000);
+  meter.add(ENERGY_I2C, 36000);
+
+  energy_report_t report = meter.getReport();
+  CHECK(fabsf(report.charge_uah[ENERGY_HPMA115] - 100.0f) < 0.01f);
+  CHECK(fabsf(report.charge_uah[ENERGY_SGP40] - 1.0f) < 0.001f);
+  CHECK(fabsf(report.charge_uah[ENERGY_I2C] - 0.01f) < 0.0001f);
+  CHECK(fabsf(report.charge_uah[ENERGY_SHTC3]) < 0.0001f);
+  CHECK(fabsf(report.total_uah - 101.01f) < 0.01f);
+}
+
+static void test_budget()
+{
+  const uint32_t budgets[] = {200000, 50000, 20000};
+  uint32_t last = 0;
+
+  // 12 cycles of 100 µAh in the first 12 minutes
+  for (uint8_t i = 0; i < sizeof(budgets) / sizeof(budgets[0]); i++)
+  {
+    EnergyMeter meter;
+    setup_meter(&meter);
+    meter.setBudget(budgets[i], TEST_MAX_INTERVAL);
+
+    // Nothing to go on before the first cycle
+    energy_plan_t plan = meter.plan(TEST_INTERVAL);
+    CHECK_EQ(plan.interval, TEST_INTERVAL);
+
+    run_cycles(&meter, 12, 10000, TEST_INTERVAL);
+    plan = meter.plan(TEST_INTERVAL);
+    CHECK(plan.hpma115);
+
+    uint32_t expected = expected_interval(budgets[i], 12, 100, 12 * TEST_INTERVAL);
+    if (expected < TEST_INTERVAL)
+      expected = TEST_INTERVAL;
+
+    CHECK(plan.interval + 1 >= expected && plan.interval <= expected + 1);
+
+    // Stretches further as the budget tightens
+    CHECK(plan.interval >= last);
+    last = plan.interval;
+  }
+
+  // Roomy budget leaves the interval alone, tighter ones stretch it
+  CHECK(last > TEST_INTERVAL);
+
+  // Stretching past the max turns the HPMA115 off instead
+  EnergyMeter meter;
+  setup_meter(&meter);
+  meter.setBudget(2000, TEST_MAX_INTERVAL);
+  run_cycles(&meter, 12, 10000, TEST_INTERVAL);
+
+  energy_plan_t plan = meter.plan(TEST_INTERVAL);
+  CHECK_EQ(plan.interval, TEST_MAX_INTERVAL);
+  CHECK(!plan.hpma115);
+
+  // Not even one more cycle left
+  meter.setBudget(1250, TEST_MAX_INTERVAL);
+  plan = meter.plan(TEST_INTERVAL);
+  CHECK_EQ(plan.interval, TEST_MAX_INTERVAL);
+  CHECK(!plan.hpma115);
+
+  // A max below the interval never shortens it
+  meter.setBudget(1250, TEST_INTERVAL / 2);
+  plan = meter.plan(TEST_INTERVAL);
+  CHECK_EQ(plan.interval, TEST_INTERVAL);
+  CHECK(!plan.hpma115);
+}
+
+static void test_state_of_charge()
+{
+  EnergyMeter meter;
+  setup_meter(&meter);
+  meter.setBudget(0, TEST_MAX_INTERVAL);
+
+  // Unknown
+  meter.setStateOfCharge(-1, 10);
+  energy_plan_t plan = meter.plan(TEST_INTERVAL);
+  CHECK_EQ(plan.interval, TEST_INTERVAL);
+  CHECK(plan.hpma115);
+
+  // Parked below the minimum, even without a budget
+  meter.setStateOfCharge(9.5f, 10);
+  plan = meter.plan(TEST_INTERVAL);
+  CHECK_EQ(plan.interval, TEST_MAX_INTERVAL);
+  CHECK(!plan.hpma115);
+
+  meter.setStateOfCharge(10, 10);
+  plan = meter.plan(TEST_INTERVAL);
+  CHECK_EQ(plan.interval, TEST_INTERVAL);
+  CHECK(plan.hpma115);
+}
+
+static void test_next_day()
+{
+  EnergyMeter meter;
+  setup_meter(&meter);
+  meter.setBudget(1250, TEST_MAX_INTERVAL);
+
+  run_cycles(&meter, 12, 10000, TEST_INTERVAL);
+  CHECK(!meter.plan(TEST_INTERVAL).hpma115);
+
+  // Still the same day
+  test_ms += ENERGY_DAY_MS - 12 * TEST_INTERVAL - 1;
+  CHECK(!meter.plan(TEST_INTERVAL).hpma115);
+
+  // A fresh budget
+  test_ms += 1;
+  energy_plan_t plan = meter.plan(TEST_INTERVAL);
+  CHECK_EQ(plan.interval, TEST_INTERVAL);
+  CHECK(plan.hpma115);
+
+  // Across a millis() wrap too
+  setup_meter(&meter);
+  test_ms = 0xffffffff - 6 * TEST_INTERVAL;
+  meter.setClock(test_clock);
+  run_cycles(&meter, 12, 10000, TEST_INTERVAL);
+  CHECK(!meter.plan(TEST_INTERVAL).hpma115);
+
+  test_ms += ENERGY_DAY_MS;
+  CHECK(meter.plan(TEST_INTERVAL).hpma115);
+}
+
+int main()
+{
+  test_accumulation();
+  test_charge();
+  test_budget();
+  test_state_of_charge();
+  test_next_day();
+
+  return test_result("energy");
+}
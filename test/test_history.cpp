@@ -0,0 +1,274 @@
+/*
+ * Project Particle Squared
+ * Description: Tiered history rollover and range queries
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include "test.h"
+#include "history.h"
+
+// On an hour boundary
+#define TEST_T0 (1700000000 / 3600 * 3600)
+
+typedef struct
+{
+  uint16_t count;
+  history_entry_t first;
+  history_entry_t last;
+  bool ordered;
+} test_collect_t;
+
+static void collect(const history_entry_t *p_entry, void *p_context)
+{
+  test_collect_t *p_collect = (test_collect_t *)p_context;
+
+  if (p_collect->count == 0)
+  {
+    p_collect->first = *p_entry;
+    p_collect->ordered = true;
+  }
+  else if (p_entry->timestamp <= p_collect->last.timestamp)
+  {
+    p_collect->ordered = false;
+  }
+
+  p_collect->last = *p_entry;
+  p_collect->count++;
+}
+
+static uint16_t run_query(History *p_history, uint8_t tier, uint32_t from, uint32_t to, test_collect_t *p_collect)
+{
+  *p_collect = {};
+  return p_history->query(tier, from, to, collect, p_collect);
+}
+
+// PM2.5 of `minute` + `second` / 10, no VOC
+static AirQualityWingData_t reading(uint32_t minute, uint32_t second)
+{
+  AirQualityWingData_t data = {};
+
+  data.hpma115.hasData = true;
+  data.hpma115.data.pm25 = minute + second / 10;
+  data.hpma115.data.pm10 = 2 * minute;
+  data.shtc3.hasData = true;
+  data.shtc3.data.temperature = -500 + minute;
+  data.shtc3.data.humidity = 4000;
+
+  return data;
+}
+
+// Six readings a minute for `minutes`, then the first of the next minute
+static void fill(History *p_history, uint32_t minutes)
+{
+  for (uint32_t m = 0; m < minutes; m++)
+  {
+    for (uint32_t s = 0; s < 60; s += 10)
+    {
+      AirQualityWingData_t data = reading(m, s);
+      p_history->add(TEST_T0 + m * 60 + s, &data);
+    }
+  }
+
+  AirQualityWingData_t data = reading(minutes, 0);
+  p_history->add(TEST_T0 + minutes * 60, &data);
+}
+
+static void test_raw()
+{
+  History history;
+  test_collect_t result;
+
+  history.clear();
+
+  // Nothing yet
+  CHECK_EQ(run_query(&history, HISTORY_RAW, 0, UINT32_MAX, &result), 0);
+
+  fill(&history, 10);
+
+  // Only the newest are kept, oldest first
+  CHECK_EQ(run_query(&history, HISTORY_RAW, 0, UINT32_MAX, &result), HISTORY_RAW_DEPTH);
+  CHECK(result.ordered);
+  CHECK_EQ(result.last.timestamp, TEST_T0 + 600);
+  CHECK_EQ(result.first.timestamp, TEST_T0 + 600 - (HISTORY_RAW_DEPTH - 1) * 10);
+
+  // Raw entries are their own min, mean and max
+  CHECK_EQ(result.last.min[AQW_CHANNEL_PM25], 10);
+  CHECK_EQ(result.last.mean[AQW_CHANNEL_PM25], 10);
+  CHECK_EQ(result.last.max[AQW_CHANNEL_PM25], 10);
+  CHECK_EQ(result.last.mean[AQW_CHANNEL_TEMPERATURE], -490);
+  CHECK_EQ(result.last.present, (1 << AQW_CHANNEL_PM25) | (1 << AQW_CHANNEL_PM10) |
+                                    (1 << AQW_CHANNEL_TEMPERATURE) | (1 << AQW_CHANNEL_HUMIDITY));
+
+  // Values past int16 are clamped
+  AirQualityWingData_t data = reading(0, 0);
+  data.hpma115.data.pm10 = 40000;
+  history.add(TEST_T0 + 610, &data);
+  CHECK_EQ(run_query(&history, HISTORY_RAW, TEST_T0 + 610, TEST_T0 + 610, &result), 1);
+  CHECK_EQ(result.last.mean[AQW_CHANNEL_PM10], INT16_MAX);
+}
+
+static void test_minute_rollover()
+{
+  History history;
+  test_collect_t result;
+
+  history.clear();
+  fill(&history, 3);
+
+  // Three closed minutes, the fourth is still open
+  CHECK_EQ(run_query(&history, HISTORY_MINUTE, 0, UINT32_MAX, &result), 3);
+  CHECK(result.ordered);
+  CHECK_EQ(result.first.timestamp, TEST_T0);
+  CHECK_EQ(result.last.timestamp, TEST_T0 + 120);
+
+  // pm25 is m..m+5 within minute m
+  CHECK_EQ(result.last.min[AQW_CHANNEL_PM25], 2);
+  CHECK_EQ(result.last.mean[AQW_CHANNEL_PM25], 4);
+  CHECK_EQ(result.last.max[AQW_CHANNEL_PM25], 7);
+  CHECK_EQ(result.last.min[AQW_CHANNEL_TEMPERATURE], -498);
+  CHECK_EQ(result.last.max[AQW_CHANNEL_TEMPERATURE], -498);
+
+  // No VOC in any reading
+  CHECK((result.last.present & (1 << AQW_CHANNEL_TVOC)) == 0);
+  CHECK(result.last.present & (1 << AQW_CHANNEL_PM25));
+
+  // A gap closes the open minute without inventing the ones in between
+  AirQualityWingData_t data = reading(10, 0);
+  history.add(TEST_T0 + 600 + 5, &data);
+  CHECK_EQ(run_query(&history, HISTORY_MINUTE, 0, UINT32_MAX, &result), 4);
+  CHECK_EQ(result.last.timestamp, TEST_T0 + 180);
+  CHECK_EQ(result.last.mean[AQW_CHANNEL_PM25], 3);
+
+  // Still open
+  CHECK_EQ(run_query(&history, HISTORY_MINUTE, TEST_T0 + 600, UINT32_MAX, &result), 0);
+
+  // The minute ring keeps the newest
+  history.clear();
+  fill(&history, HISTORY_MINUTE_DEPTH + 5);
+  CHECK_EQ(run_query(&history, HISTORY_MINUTE, 0, UINT32_MAX, &result), HISTORY_MINUTE_DEPTH);
+  CHECK(result.ordered);
+  CHECK_EQ(result.first.timestamp, TEST_T0 + 5 * 60);
+  CHECK_EQ(result.last.timestamp, TEST_T0 + (HISTORY_MINUTE_DEPTH + 4) * 60);
+}
+
+static void test_hour_rollover()
+{
+  History history;
+  test_collect_t result;
+
+  history.clear();
+  fill(&history, 59);
+
+  // Not until the hour is over
+  CHECK_EQ(run_query(&history, HISTORY_HOUR, 0, UINT32_MAX, &result), 0);
+
+  history.clear();
+  fill(&history, 90);
+
+  CHECK_EQ(run_query(&history, HISTORY_HOUR, 0, UINT32_MAX, &result), 1);
+  CHECK_EQ(result.last.timestamp, TEST_T0);
+
+  // Minutes 0..59 folded in: 0 to 59 + 5, mean of 6m + 15 over 360 samples
+  CHECK_EQ(result.last.min[AQW_CHANNEL_PM25], 0);
+  CHECK_EQ(result.last.max[AQW_CHANNEL_PM25], 64);
+  CHECK_EQ(result.last.mean[AQW_CHANNEL_PM25], 32);
+  CHECK_EQ(result.last.min[AQW_CHANNEL_PM10], 0);
+  CHECK_EQ(result.last.max[AQW_CHANNEL_PM10], 118);
+  CHECK_EQ(result.last.mean[AQW_CHANNEL_PM10], 59);
+  CHECK((result.last.present & (1 << AQW_CHANNEL_TVOC)) == 0);
+
+  // Hour means are weighted by samples, not minutes
+  history.clear();
+  for (uint32_t s = 0; s < 60; s += 10)
+  {
+    AirQualityWingData_t data = reading(0, 0);
+    data.hpma115.data.pm25 = 10;
+    history.add(TEST_T0 + s, &data);
+  }
+
+  AirQualityWingData_t data = reading(0, 0);
+  data.hpma115.data.pm25 = 70;
+  history.add(TEST_T0 + 60, &data);
+  history.add(TEST_T0 + 3600, &data);
+
+  CHECK_EQ(run_query(&history, HISTORY_HOUR, 0, UINT32_MAX, &result), 1);
+  CHECK_EQ(result.last.mean[AQW_CHANNEL_PM25], (6 * 10 + 70) / 7);
+}
+
+static void test_ranges()
+{
+  History history;
+  test_collect_t result;
+  history_stat_t stat;
+
+  history.clear();
+  fill(&history, 20);
+
+  // Inclusive at both ends
+  CHECK_EQ(run_query(&history, HISTORY_MINUTE, TEST_T0 + 5 * 60, TEST_T0 + 10 * 60, &result), 6);
+  CHECK_EQ(result.first.timestamp, TEST_T0 + 5 * 60);
+  CHECK_EQ(result.last.timestamp, TEST_T0 + 10 * 60);
+
+  // Just inside and outside an entry
+  CHECK_EQ(run_query(&history, HISTORY_MINUTE, TEST_T0 + 5 * 60 + 1, TEST_T0 + 10 * 60 - 1, &result), 4);
+
+  // Empty and backwards ranges
+  CHECK_EQ(run_query(&history, HISTORY_MINUTE, TEST_T0 + 30, TEST_T0 + 59, &result), 0);
+  CHECK_EQ(run_query(&history, HISTORY_MINUTE, TEST_T0 + 600, TEST_T0, &result), 0);
+  CHECK_EQ(run_query(&history, HISTORY_MINUTE, 0, TEST_T0 - 1, &result), 0);
+
+  // Unknown tier
+  CHECK_EQ(run_query(&history, HISTORY_HOUR + 1, 0, UINT32_MAX, &result), 0);
+
+  // Minutes 5..10: min 5, max 15, mean of the minute means 7..12
+  CHECK(history.aggregate(HISTORY_MINUTE, AQW_CHANNEL_PM25, TEST_T0 + 5 * 60, TEST_T0 + 10 * 60, &stat));
+  CHECK_EQ(stat.count, 6);
+  CHECK_EQ(stat.min, 5);
+  CHECK_EQ(stat.max, 15);
+  CHECK_EQ(stat.mean, (7 + 8 + 9 + 10 + 11 + 12) / 6);
+
+  // Raw tier, the last 32 readings
+  CHECK(history.aggregate(HISTORY_RAW, AQW_CHANNEL_TEMPERATURE, 0, UINT32_MAX, &stat));
+  CHECK_EQ(stat.count, HISTORY_RAW_DEPTH);
+  CHECK_EQ(stat.max, -480);
+
+  // Channels nobody reported, or that don't exist
+  CHECK(!history.aggregate(HISTORY_MINUTE, AQW_CHANNEL_TVOC, 0, UINT32_MAX, &stat));
+  CHECK(!history.aggregate(HISTORY_MINUTE, AQW_CHANNEL_COUNT, 0, UINT32_MAX, &stat));
+  CHECK(!history.aggregate(HISTORY_MINUTE, AQW_CHANNEL_PM25, TEST_T0 + 30, TEST_T0 + 59, &stat));
+}
+
+static void test_begin()
+{
+  History history;
+  test_collect_t result;
+
+  history.clear();
+  fill(&history, 5);
+
+  // What's there stays, like retained RAM across a reset
+  History after;
+  after.begin();
+  CHECK_EQ(run_query(&after, HISTORY_MINUTE, 0, UINT32_MAX, &result), 5);
+
+  // And carries on from the open minute
+  AirQualityWingData_t data = reading(6, 0);
+  after.add(TEST_T0 + 6 * 60, &data);
+  CHECK_EQ(run_query(&after, HISTORY_MINUTE, 0, UINT32_MAX, &result), 6);
+
+  after.clear();
+  CHECK_EQ(run_query(&after, HISTORY_RAW, 0, UINT32_MAX, &result), 0);
+}
+
+int main()
+{
+  test_raw();
+  test_minute_rollover();
+  test_hour_rollover();
+  test_ranges();
+  test_begin();
+
+  return test_result("history");
+}
@@ -0,0 +1,88 @@
+/*
+ * Project Particle Squared
+ * Description: JSON writer output against the old toString() format
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include <string.h>
+
+#include "test.h"
+#include "reference.h"
+#include "json_writer.h"
+
+static void test_matches_reference()
+{
+  char buf[JSON_MAX_SIZE];
+  uint32_t mismatches = 0;
+
+  // Every sensor combination, values across the whole range
+  for (uint32_t i = 0; i < 8 * 4096; i++)
+  {
+    AirQualityWingData_t data = {};
+    uint32_t v = i / 8;
+
+    data.hpma115.hasData = i & 1;
+    data.shtc3.hasData = i & 2;
+    data.sgp40.hasData = i & 4;
+    data.hpma115.data.pm25 = v * 16;
+    data.hpma115.data.pm10 = 65535 - v * 16;
+    data.shtc3.data.temperature = (int16_t)(v * 16 - 32768);
+    data.shtc3.data.humidity = v * 16 + 15;
+    data.sgp40.data.tvoc = (int32_t)(v * 1048573u + 0x80000001u);
+
+    size_t len = json_write(&data, JSON_FIELD_ALL, buf, sizeof(buf));
+
+    if (len == 0 || strlen(buf) != len || ref_to_string(&data) != buf)
+      mismatches++;
+  }
+
+  CHECK_EQ(mismatches, 0);
+}
+
+static void test_limits()
+{
+  char buf[JSON_MAX_SIZE];
+  AirQualityWingData_t data = {};
+
+  // Widest value of every field fits JSON_MAX_SIZE
+  data.hpma115.hasData = data.shtc3.hasData = data.sgp40.hasData = data.aqi.hasData = true;
+  data.hpma115.data.pm25 = data.hpma115.data.pm10 = 65535;
+  data.shtc3.data.temperature = INT16_MIN;
+  data.shtc3.data.humidity = 65535;
+  data.sgp40.data.tvoc = INT32_MIN;
+  data.aqi.data.aqi = 65535;
+
+  size_t len = json_write(&data, JSON_FIELD_ALL | JSON_FIELD_AQI, buf, sizeof(buf));
+  CHECK(len > 0);
+  CHECK_EQ(len + 1, JSON_MAX_SIZE);
+
+  // One byte short doesn't fit and writes nothing past the buffer
+  char small[JSON_MAX_SIZE];
+  memset(small, 'x', sizeof(small));
+  CHECK_EQ(json_write(&data, JSON_FIELD_ALL | JSON_FIELD_AQI, small, JSON_MAX_SIZE - 1), 0);
+  CHECK_EQ(small[JSON_MAX_SIZE - 1], 'x');
+
+  // AQI only when asked for
+  CHECK_EQ(JSON_MAX_SIZE, 99);
+  CHECK(json_write(&data, JSON_FIELD_ALL, buf, sizeof(buf)) > 0);
+  CHECK(strstr(buf, "\"aqi\"") == NULL);
+
+  // Field mask
+  data.sgp40.data.tvoc = 42;
+  CHECK(json_write(&data, JSON_FIELD_TVOC, buf, sizeof(buf)) > 0);
+  CHECK(strcmp(buf, "{\"tvoc\":42}") == 0);
+
+  // Nothing selected
+  CHECK(json_write(&data, 0, buf, sizeof(buf)) > 0);
+  CHECK(strcmp(buf, "{}") == 0);
+}
+
+int main()
+{
+  test_matches_reference();
+  test_limits();
+
+  return test_result("json");
+}
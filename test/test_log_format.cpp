@@ -0,0 +1,200 @@
+/*
+ * Project Particle Squared
+ * Description: On-flash log format round trips, CRC checks and torn tails
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include <string.h>
+
+#include "test.h"
+#include "fixtures.h"
+#include "crc32.h"
+#include "log_format.h"
+
+#define TEST_RECORDS 5
+
+typedef struct
+{
+  uint32_t count;
+  uint32_t stop_at;
+  uint32_t last_seq;
+} test_parse_t;
+
+static bool count_record(const log_record_t *p_record, void *p_context)
+{
+  test_parse_t *p_parse = (test_parse_t *)p_context;
+
+  p_parse->count++;
+  p_parse->last_seq = p_record->seq;
+
+  return p_parse->count != p_parse->stop_at;
+}
+
+// TEST_RECORDS records back to back, returns the offset each one ends at
+static size_t build_log(uint8_t *p_buf, size_t size, size_t *p_ends)
+{
+  size_t len = 0;
+
+  for (uint32_t i = 0; i < TEST_RECORDS; i++)
+  {
+    AirQualityWingData_t data = fixture_reading(i);
+    len += log_record_encode(100 + i, 1700000000 + i * 60, &data, &p_buf[len], size - len);
+    p_ends[i] = len;
+  }
+
+  return len;
+}
+
+static void test_crc32()
+{
+  const uint8_t check[] = "123456789";
+
+  // Standard check value
+  CHECK_EQ(crc32(check, 9), 0xcbf43926);
+  CHECK_EQ(crc32(check, 0), 0);
+
+  // Continues across buffers
+  CHECK_EQ(crc32(&check[4], 5, crc32(check, 4)), 0xcbf43926);
+}
+
+static void test_segment_header()
+{
+  uint8_t buf[LOG_SEGMENT_HEADER_SIZE];
+  log_segment_t segment = {0x12345678, 0xfffffff0}, decoded;
+
+  CHECK_EQ(log_segment_encode(&segment, buf, sizeof(buf) - 1), 0);
+  CHECK_EQ(log_segment_encode(&segment, buf, sizeof(buf)), LOG_SEGMENT_HEADER_SIZE);
+
+  // Little endian, magic first
+  CHECK(memcmp(buf, "AQWL", 4) == 0);
+  CHECK_EQ(buf[4], LOG_VERSION);
+  CHECK_EQ(buf[8], 0x78);
+  CHECK_EQ(buf[15], 0xff);
+
+  CHECK_EQ(log_segment_decode(buf, sizeof(buf), &decoded), LOG_SUCCESS);
+  CHECK_EQ(decoded.segment, segment.segment);
+  CHECK_EQ(decoded.first_seq, segment.first_seq);
+
+  CHECK_EQ(log_segment_decode(buf, sizeof(buf) - 1, &decoded), LOG_TRUNCATED);
+
+  buf[4] = LOG_VERSION + 1;
+  CHECK_EQ(log_segment_decode(buf, sizeof(buf), &decoded), LOG_BAD_VERSION);
+
+  buf[0] ^= 1;
+  CHECK_EQ(log_segment_decode(buf, sizeof(buf), &decoded), LOG_CORRUPT);
+}
+
+static void test_record_round_trip()
+{
+  uint8_t buf[LOG_RECORD_MAX_SIZE];
+  log_record_t record;
+  size_t used = 0;
+
+  for (uint32_t i = 0; i < 100; i++)
+  {
+    AirQualityWingData_t data = fixture_reading(i);
+
+    // Some channels missing
+    data.sgp40.hasData = i % 3 != 0;
+    data.hpma115.hasData = i % 5 != 0;
+
+    size_t len = log_record_encode(i * 7919, 1700000000 + i, &data, buf, sizeof(buf));
+    CHECK(len > LOG_RECORD_HEADER_SIZE + LOG_RECORD_CRC_SIZE && len <= LOG_RECORD_MAX_SIZE);
+    CHECK_EQ(buf[0], LOG_RECORD_MAGIC);
+    CHECK_EQ(buf[1], len - LOG_RECORD_HEADER_SIZE - LOG_RECORD_CRC_SIZE);
+
+    CHECK_EQ(log_record_decode(buf, len, &record, &used), LOG_SUCCESS);
+    CHECK_EQ(used, len);
+    CHECK_EQ(record.seq, i * 7919);
+    CHECK_EQ(record.timestamp, 1700000000 + i);
+    CHECK(fixture_equal(&data, &record.data));
+
+    // Extra bytes after it aren't consumed
+    CHECK_EQ(log_record_decode(buf, sizeof(buf), &record, nullptr), LOG_SUCCESS);
+  }
+
+  // Too small a buffer
+  AirQualityWingData_t data = fixture_reading(0);
+  CHECK_EQ(log_record_encode(1, 1, &data, buf, LOG_RECORD_HEADER_SIZE + LOG_RECORD_CRC_SIZE - 1), 0);
+  CHECK_EQ(log_record_encode(1, 1, &data, buf, LOG_RECORD_HEADER_SIZE + LOG_RECORD_CRC_SIZE + 1), 0);
+}
+
+static void test_crc_rejection()
+{
+  uint8_t buf[LOG_RECORD_MAX_SIZE];
+  log_record_t record;
+
+  AirQualityWingData_t data = fixture_reading(3);
+  size_t len = log_record_encode(42, 1700000000, &data, buf, sizeof(buf));
+
+  // Any single bit flip is caught
+  for (size_t i = 0; i < len; i++)
+  {
+    for (uint8_t bit = 0; bit < 8; bit++)
+    {
+      buf[i] ^= 1 << bit;
+      CHECK(log_record_decode(buf, len, &record, nullptr) != LOG_SUCCESS);
+      buf[i] ^= 1 << bit;
+    }
+  }
+
+  CHECK_EQ(log_record_decode(buf, len, &record, nullptr), LOG_SUCCESS);
+
+  // A length past the codec's maximum is rejected before it's trusted
+  buf[1] = RECORD_MAX_SIZE + 1;
+  CHECK_EQ(log_record_decode(buf, sizeof(buf), &record, nullptr), LOG_CORRUPT);
+}
+
+static void test_torn_tail()
+{
+  uint8_t buf[TEST_RECORDS * LOG_RECORD_MAX_SIZE + 16];
+  size_t ends[TEST_RECORDS];
+  test_parse_t parse;
+
+  size_t len = build_log(buf, sizeof(buf), ends);
+
+  // Whole log
+  parse = {0, 0, 0};
+  CHECK_EQ(log_parse(buf, len, count_record, &parse), len);
+  CHECK_EQ(parse.count, TEST_RECORDS);
+  CHECK_EQ(parse.last_seq, 100 + TEST_RECORDS - 1);
+
+  // Cut anywhere inside the last record, it's dropped and the rest stays
+  for (size_t cut = ends[TEST_RECORDS - 2]; cut < len; cut++)
+  {
+    parse = {0, 0, 0};
+    CHECK_EQ(log_parse(buf, cut, count_record, &parse), ends[TEST_RECORDS - 2]);
+    CHECK_EQ(parse.count, TEST_RECORDS - 1);
+  }
+
+  // Erased flash after the last record
+  memset(&buf[len], 0xff, 16);
+  CHECK_EQ(log_parse(buf, len + 16, nullptr, nullptr), len);
+
+  // A torn write in the middle stops the walk there
+  buf[ends[1] + LOG_RECORD_HEADER_SIZE] ^= 0x80;
+  parse = {0, 0, 0};
+  CHECK_EQ(log_parse(buf, len, count_record, &parse), ends[1]);
+  CHECK_EQ(parse.count, 2);
+  buf[ends[1] + LOG_RECORD_HEADER_SIZE] ^= 0x80;
+
+  // Callback can stop early
+  parse = {0, 3, 0};
+  CHECK_EQ(log_parse(buf, len, count_record, &parse), ends[1]);
+  CHECK_EQ(parse.last_seq, 102);
+
+  CHECK_EQ(log_parse(buf, 0, count_record, &parse), 0);
+}
+
+int main()
+{
+  test_crc32();
+  test_segment_header();
+  test_record_round_trip();
+  test_crc_rejection();
+  test_torn_tail();
+
+  return test_result("log_format");
+}
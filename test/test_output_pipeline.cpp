@@ -0,0 +1,327 @@
+/*
+ * Project Particle Squared
+ * Description: Output sink batching, flushing, rate limits and oversize drops
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include <string.h>
+
+#include "test.h"
+#include "fixtures.h"
+#include "output_pipeline.h"
+
+// Built with a small publish size (see the Makefile) so a full JSON
+// reading doesn't fit a write and a few binary records fill one
+static_assert(OUTPUT_BUFFER_SIZE < 64, "test expects the small buffer build");
+
+#define TEST_MAX_WRITES 16
+
+typedef struct
+{
+  bool accept;
+  uint8_t count;
+  size_t len[TEST_MAX_WRITES];
+  uint8_t buf[TEST_MAX_WRITES][OUTPUT_BUFFER_SIZE + 1];
+} test_capture_t;
+
+static output_write_t capture(test_capture_t *p_capture)
+{
+  memset(p_capture, 0, sizeof(test_capture_t));
+  p_capture->accept = true;
+
+  return [p_capture](const uint8_t *p_buf, size_t len) -> bool
+  {
+    if (!p_capture->accept || p_capture->count == TEST_MAX_WRITES)
+      return false;
+
+    memcpy(p_capture->buf[p_capture->count], p_buf, len);
+    p_capture->len[p_capture->count++] = len;
+    return true;
+  };
+}
+
+static output_sink_config_t binary_sink(uint8_t batch, uint32_t flush_ms)
+{
+  output_sink_config_t config = {};
+
+  config.encoding = OUTPUT_BINARY;
+  config.batch = batch;
+  config.flush_ms = flush_ms;
+  config.policy = RESULT_QUEUE_DROP_NEWEST;
+
+  return config;
+}
+
+// Readings with pm25 = i, so their order can be checked
+static AirQualityWingData_t numbered(uint32_t i)
+{
+  AirQualityWingData_t data = fixture_reading(i);
+  data.hpma115.data.pm25 = i;
+  return data;
+}
+
+static size_t record_size(uint32_t i)
+{
+  uint8_t buf[RECORD_MAX_SIZE];
+  AirQualityWingData_t data = numbered(i);
+
+  return record_encode(&data, buf, sizeof(buf));
+}
+
+// Decodes the records of one write, checking they count up from `*p_next`
+static uint8_t check_records(const uint8_t *p_buf, size_t len, uint32_t *p_next)
+{
+  uint8_t count = 0;
+  size_t pos = 0, used;
+  AirQualityWingData_t data;
+
+  while (pos < len && record_decode(&p_buf[pos], len - pos, &data, &used) == RECORD_SUCCESS)
+  {
+    CHECK_EQ(data.hpma115.data.pm25, *p_next);
+    (*p_next)++;
+    pos += used;
+    count++;
+  }
+
+  CHECK_EQ(pos, len);
+
+  return count;
+}
+
+static void test_batching()
+{
+  OutputPipeline pipeline;
+  test_capture_t out;
+  uint32_t next = 0;
+
+  output_sink_config_t config = binary_sink(3, 0);
+  int id = pipeline.addSink(&config, capture(&out));
+  CHECK_EQ(id, 0);
+
+  // Waits for a full batch
+  for (uint32_t i = 0; i < 2; i++)
+  {
+    AirQualityWingData_t data = numbered(i);
+    pipeline.push(1 + i, 0, &data);
+    pipeline.process(1 + i);
+  }
+  CHECK_EQ(out.count, 0);
+
+  AirQualityWingData_t data = numbered(2);
+  pipeline.push(3, 0, &data);
+  pipeline.process(3);
+  CHECK_EQ(out.count, 1);
+  CHECK_EQ(out.len[0], record_size(0) + record_size(1) + record_size(2));
+  CHECK_EQ(check_records(out.buf[0], out.len[0], &next), 3);
+
+  // Every sink gets every reading
+  test_capture_t other;
+  config = binary_sink(1, 0);
+  CHECK_EQ(pipeline.addSink(&config, capture(&other)), 1);
+
+  data = numbered(3);
+  pipeline.push(4, 0, &data);
+  pipeline.process(4);
+  CHECK_EQ(other.count, 1);
+  CHECK_EQ(out.count, 1);
+
+  output_sink_stats_t stats = pipeline.getStats(id);
+  CHECK_EQ(stats.writes, 1);
+  CHECK_EQ(stats.readings, 3);
+  CHECK_EQ(stats.bytes, out.len[0]);
+  CHECK_EQ(stats.queue.pushed, 4);
+
+  // Gone once removed
+  pipeline.removeSink(1);
+  pipeline.push(5, 0, &data);
+  pipeline.process(5);
+  CHECK_EQ(other.count, 1);
+}
+
+static void test_flush()
+{
+  OutputPipeline pipeline;
+  test_capture_t out;
+  uint32_t next = 0;
+
+  output_sink_config_t config = binary_sink(10, 1000);
+  int id = pipeline.addSink(&config, capture(&out));
+
+  AirQualityWingData_t data = numbered(0);
+  pipeline.push(100, 0, &data);
+  pipeline.process(100);
+
+  // Timed from the oldest reading, not the latest
+  data = numbered(1);
+  pipeline.push(600, 0, &data);
+  pipeline.process(1099);
+  CHECK_EQ(out.count, 0);
+
+  pipeline.process(1100);
+  CHECK_EQ(out.count, 1);
+  CHECK_EQ(check_records(out.buf[0], out.len[0], &next), 2);
+
+  // Nothing to flush
+  pipeline.process(5000);
+  CHECK_EQ(out.count, 1);
+
+  CHECK_EQ(pipeline.getStats(id).readings, 2);
+}
+
+static void test_token_bucket()
+{
+  OutputPipeline pipeline;
+  test_capture_t out;
+
+  output_sink_config_t config = binary_sink(1, 0);
+  config.rate_ms = 1000;
+  config.burst = 2;
+  int id = pipeline.addSink(&config, capture(&out));
+
+  for (uint32_t i = 0; i < 6; i++)
+  {
+    AirQualityWingData_t data = numbered(i);
+    pipeline.push(1, 0, &data);
+  }
+
+  // A burst of two, then one a second
+  pipeline.process(1);
+  pipeline.process(2);
+  CHECK_EQ(out.count, 2);
+
+  pipeline.process(3);
+  pipeline.process(500);
+  pipeline.process(1000);
+  CHECK_EQ(out.count, 2);
+
+  pipeline.process(1001);
+  CHECK_EQ(out.count, 3);
+  pipeline.process(1002);
+  pipeline.process(2000);
+  CHECK_EQ(out.count, 3);
+  pipeline.process(2001);
+  CHECK_EQ(out.count, 4);
+
+  // The bucket holds no more than the burst after a quiet spell
+  pipeline.process(100000);
+  pipeline.process(100001);
+  pipeline.process(100002);
+  CHECK_EQ(out.count, 6);
+
+  // Each held write counts once, however often it's retried
+  output_sink_stats_t stats = pipeline.getStats(id, true);
+  CHECK_EQ(stats.rate_limited, 2);
+  CHECK_EQ(stats.writes, 6);
+  CHECK_EQ(pipeline.getStats(id).rate_limited, 0);
+
+  // In order throughout
+  uint32_t next = 0;
+  for (uint8_t i = 0; i < out.count; i++)
+    check_records(out.buf[i], out.len[i], &next);
+  CHECK_EQ(next, 6);
+}
+
+static void test_carry_over()
+{
+  OutputPipeline pipeline;
+  test_capture_t out;
+  uint32_t next = 0;
+
+  // More readings than fit one write
+  output_sink_config_t config = binary_sink(OUTPUT_QUEUE_DEPTH, 1);
+  int id = pipeline.addSink(&config, capture(&out));
+
+  size_t total = 0;
+  for (uint32_t i = 0; i < OUTPUT_QUEUE_DEPTH; i++)
+  {
+    AirQualityWingData_t data = numbered(i);
+    pipeline.push(1, 0, &data);
+    total += record_size(i);
+  }
+  CHECK(total > OUTPUT_BUFFER_SIZE);
+
+  // A full buffer goes out straight away, the reading that didn't fit leads the next
+  pipeline.process(1);
+  CHECK_EQ(out.count, 1);
+  CHECK(out.len[0] <= OUTPUT_BUFFER_SIZE);
+
+  uint8_t first = check_records(out.buf[0], out.len[0], &next);
+  CHECK(first > 0 && first < OUTPUT_QUEUE_DEPTH);
+  CHECK(out.len[0] + record_size(first) > OUTPUT_BUFFER_SIZE);
+
+  // A rejected write is offered again as is
+  out.accept = false;
+  pipeline.process(2);
+  pipeline.process(3);
+  CHECK_EQ(out.count, 1);
+
+  out.accept = true;
+  while (next < OUTPUT_QUEUE_DEPTH && out.count < TEST_MAX_WRITES)
+  {
+    pipeline.process(4 + out.count);
+    check_records(out.buf[out.count - 1], out.len[out.count - 1], &next);
+  }
+
+  CHECK_EQ(next, OUTPUT_QUEUE_DEPTH);
+
+  output_sink_stats_t stats = pipeline.getStats(id);
+  CHECK_EQ(stats.readings, OUTPUT_QUEUE_DEPTH);
+  CHECK_EQ(stats.rejected, 2);
+  CHECK_EQ(stats.dropped_oversize, 0);
+}
+
+static void test_oversize()
+{
+  OutputPipeline pipeline;
+  test_capture_t out;
+
+  output_sink_config_t config = {};
+  config.encoding = OUTPUT_JSON;
+  config.batch = 1;
+  config.policy = RESULT_QUEUE_DROP_NEWEST;
+  int id = pipeline.addSink(&config, capture(&out));
+
+  // Every channel is too much for the buffer, one alone fits
+  AirQualityWingData_t full = fixture_reading(0);
+  AirQualityWingData_t small = {};
+  small.hpma115.hasData = true;
+  small.hpma115.data.pm25 = 12;
+
+  char json[JSON_MAX_SIZE];
+  CHECK(json_write(&full, JSON_FIELD_ALL, json, sizeof(json)) > OUTPUT_BUFFER_SIZE);
+
+  for (uint32_t i = 0; i < 3; i++)
+  {
+    pipeline.push(1 + i, 0, &full);
+    pipeline.push(1 + i, 0, &small);
+  }
+
+  // Dropped without holding up the readings behind them
+  for (uint32_t t = 1; t < 10; t++)
+    pipeline.process(t);
+
+  CHECK_EQ(out.count, 3);
+  out.buf[0][out.len[0]] = 0;
+  CHECK(strstr((const char *)out.buf[0], "\"pm25\"") != nullptr);
+
+  output_sink_stats_t stats = pipeline.getStats(id, true);
+  CHECK_EQ(stats.dropped_oversize, 3);
+  CHECK_EQ(stats.writes, 3);
+  CHECK_EQ(stats.readings, 3);
+
+  stats = pipeline.getStats(id);
+  CHECK_EQ(stats.dropped_oversize, 0);
+}
+
+int main()
+{
+  test_batching();
+  test_flush();
+  test_token_bucket();
+  test_carry_over();
+  test_oversize();
+
+  return test_result("output_pipeline");
+}
@@ -0,0 +1,109 @@
+/*
+ * Project Particle Squared
+ * Description: log2 histogram buckets and percentiles
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include <string.h>
+
+#include "test.h"
+#include "perf_stats.h"
+
+// Bucket `value` lands in, from a histogram of just it
+static int8_t bucket_of(uint32_t value)
+{
+  perf_hist_t hist;
+  memset(&hist, 0, sizeof(hist));
+
+  perf_hist_add(&hist, value);
+
+  for (uint8_t i = 0; i < PERF_HIST_BUCKETS; i++)
+    if (hist.buckets[i])
+      return i;
+
+  return -1;
+}
+
+static void test_buckets()
+{
+  CHECK_EQ(bucket_of(0), 0);
+  CHECK_EQ(bucket_of(1), 0);
+
+  // Each power of two opens its bucket, the value before it closes the last
+  for (uint8_t n = 1; n < PERF_HIST_BUCKETS; n++)
+  {
+    CHECK_EQ(bucket_of(1UL << n), n);
+    CHECK_EQ(bucket_of((1UL << n) - 1), n - 1);
+    CHECK_EQ(bucket_of((1UL << n) + 1), n);
+  }
+
+  // Everything past the last edge goes in the last bucket
+  CHECK_EQ(bucket_of(1UL << PERF_HIST_BUCKETS), PERF_HIST_BUCKETS - 1);
+  CHECK_EQ(bucket_of(1UL << 31), PERF_HIST_BUCKETS - 1);
+  CHECK_EQ(bucket_of(UINT32_MAX), PERF_HIST_BUCKETS - 1);
+
+  perf_hist_t hist;
+  memset(&hist, 0, sizeof(hist));
+  perf_hist_add(&hist, 5);
+  perf_hist_add(&hist, UINT32_MAX);
+  perf_hist_add(&hist, 0);
+  CHECK_EQ(hist.count, 3);
+  CHECK_EQ(hist.max, UINT32_MAX);
+}
+
+static void test_percentiles()
+{
+  perf_hist_t hist;
+  memset(&hist, 0, sizeof(hist));
+
+  // Empty
+  CHECK_EQ(perf_hist_percentile(&hist, 50), 0);
+
+  // 1..100, one each
+  for (uint32_t i = 1; i <= 100; i++)
+    perf_hist_add(&hist, i);
+
+  // Upper bound of the bucket holding the ranked sample
+  CHECK_EQ(perf_hist_percentile(&hist, 0), 1);  // Rank 1
+  CHECK_EQ(perf_hist_percentile(&hist, 1), 1);  // Rank 1
+  CHECK_EQ(perf_hist_percentile(&hist, 2), 3);  // Rank 2, [2, 4)
+  CHECK_EQ(perf_hist_percentile(&hist, 3), 3);  // Rank 3
+  CHECK_EQ(perf_hist_percentile(&hist, 4), 7);  // Rank 4, [4, 8)
+  CHECK_EQ(perf_hist_percentile(&hist, 50), 63); // Rank 50, [32, 64)
+  CHECK_EQ(perf_hist_percentile(&hist, 63), 63);
+  CHECK_EQ(perf_hist_percentile(&hist, 64), 100); // [64, 128), capped at the max
+  CHECK_EQ(perf_hist_percentile(&hist, 99), 100);
+  CHECK_EQ(perf_hist_percentile(&hist, 100), 100);
+
+  // Rank rounds up: the 50th percentile of 3 samples is the 2nd
+  memset(&hist, 0, sizeof(hist));
+  perf_hist_add(&hist, 1);
+  perf_hist_add(&hist, 10);
+  perf_hist_add(&hist, 1000);
+  CHECK_EQ(perf_hist_percentile(&hist, 50), 15);
+  CHECK_EQ(perf_hist_percentile(&hist, 34), 15);
+  CHECK_EQ(perf_hist_percentile(&hist, 33), 1);
+  CHECK_EQ(perf_hist_percentile(&hist, 90), 1000);
+
+  // Open ended last bucket reports the max
+  memset(&hist, 0, sizeof(hist));
+  for (uint32_t i = 0; i < 9; i++)
+    perf_hist_add(&hist, 100);
+  perf_hist_add(&hist, 5000000);
+  CHECK_EQ(perf_hist_percentile(&hist, 90), 127);
+  CHECK_EQ(perf_hist_percentile(&hist, 95), 5000000);
+
+  memset(&hist, 0, sizeof(hist));
+  perf_hist_add(&hist, UINT32_MAX);
+  CHECK_EQ(perf_hist_percentile(&hist, 50), UINT32_MAX);
+}
+
+int main()
+{
+  test_buckets();
+  test_percentiles();
+
+  return test_result("perf_stats");
+}
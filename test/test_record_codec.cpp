@@ -0,0 +1,92 @@
+/*
+ * Project Particle Squared
+ * Description: Record codec round trips, edge values and malformed input
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include "test.h"
+#include "fixtures.h"
+#include "record_codec.h"
+
+static bool round_trip(const AirQualityWingData_t *p_data)
+{
+  uint8_t buf[RECORD_MAX_SIZE];
+  AirQualityWingData_t decoded;
+  size_t used = 0;
+
+  size_t len = record_encode(p_data, buf, sizeof(buf));
+
+  return len > 0 && record_decode(buf, len, &decoded, &used) == RECORD_SUCCESS && used == len &&
+         fixture_equal(p_data, &decoded);
+}
+
+static void test_edges()
+{
+  AirQualityWingData_t data = {};
+
+  data.hpma115.hasData = data.shtc3.hasData = data.sgp40.hasData = true;
+
+  // Widest values, both ends
+  data.hpma115.data.pm25 = data.hpma115.data.pm10 = 65535;
+  data.shtc3.data.temperature = INT16_MIN;
+  data.shtc3.data.humidity = 65535;
+  data.sgp40.data.tvoc = INT32_MIN;
+  CHECK(round_trip(&data));
+
+  uint8_t buf[RECORD_MAX_SIZE];
+  CHECK(record_encode(&data, buf, sizeof(buf)) <= RECORD_MAX_SIZE);
+
+  data.hpma115.data.pm25 = data.hpma115.data.pm10 = 0;
+  data.shtc3.data.temperature = INT16_MAX;
+  data.shtc3.data.humidity = 0;
+  data.sgp40.data.tvoc = INT32_MAX;
+  CHECK(round_trip(&data));
+
+  data.sgp40.data.tvoc = -1;
+  CHECK(round_trip(&data));
+
+  // Every presence combination, including none at all
+  for (uint8_t mask = 0; mask < 8; mask++)
+  {
+    data = fixture_reading(mask);
+    data.hpma115.hasData = mask & 1;
+    data.shtc3.hasData = mask & 2;
+    data.sgp40.hasData = mask & 4;
+    CHECK(round_trip(&data));
+  }
+
+  // Empty bitmap is just the header
+  data = AirQualityWingData_t();
+  CHECK_EQ(record_encode(&data, buf, sizeof(buf)), 2);
+  CHECK_EQ(buf[0], RECORD_VERSION);
+  CHECK_EQ(buf[1], 0);
+}
+
+static void test_malformed()
+{
+  AirQualityWingData_t data = fixture_reading(3), decoded;
+  uint8_t buf[RECORD_MAX_SIZE];
+  size_t len = record_encode(&data, buf, sizeof(buf));
+
+  // Every truncation is caught
+  for (size_t i = 0; i < len; i++)
+    CHECK_EQ(record_decode(buf, i, &decoded, nullptr), RECORD_TRUNCATED);
+
+  // Too small a buffer writes nothing usable
+  for (size_t i = 0; i < len; i++)
+    CHECK_EQ(record_encode(&data, buf, i), 0);
+
+  len = record_encode(&data, buf, sizeof(buf));
+  buf[0] = RECORD_VERSION + 1;
+  CHECK_EQ(record_decode(buf, len, &decoded, nullptr), RECORD_BAD_VERSION);
+}
+
+int main()
+{
+  test_edges();
+  test_malformed();
+
+  return test_result("record_codec");
+}
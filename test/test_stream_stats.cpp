@@ -0,0 +1,220 @@
+/*
+ * Project Particle Squared
+ * Description: Welford and P² estimators against two-pass references
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "test.h"
+#include "stream_stats.h"
+
+#define TEST_SAMPLES 10000
+
+static uint32_t test_seed = 1;
+
+// Uniform in [0, 1000)
+static float test_uniform()
+{
+  test_seed = test_seed * 1103515245 + 12345;
+  return (float)((test_seed >> 8) % 100000) / 100;
+}
+
+static int compare_float(const void *p_a, const void *p_b)
+{
+  float a = *(const float *)p_a, b = *(const float *)p_b;
+  return a < b ? -1 : a > b;
+}
+
+// Nearest rank on a sorted copy
+static float reference_quantile(const float *p_sorted, uint32_t count, float p)
+{
+  return p_sorted[(uint32_t)(p * (count - 1) + 0.5f)];
+}
+
+static void test_welford()
+{
+  static float values[TEST_SAMPLES];
+  welford_t w;
+  double sum = 0, squares = 0;
+
+  welford_reset(&w);
+
+  // Temperature-like, a large offset and small spread is where a
+  // one-pass sum of squares loses it
+  for (uint32_t i = 0; i < TEST_SAMPLES; i++)
+  {
+    values[i] = 2150 + test_uniform() / 50;
+    welford_add(&w, values[i]);
+    sum += values[i];
+  }
+
+  double mean = sum / TEST_SAMPLES;
+  for (uint32_t i = 0; i < TEST_SAMPLES; i++)
+    squares += (values[i] - mean) * (values[i] - mean);
+  double variance = squares / (TEST_SAMPLES - 1);
+
+  CHECK_EQ(w.count, TEST_SAMPLES);
+  // Float resolution at this offset is about 2e-4
+  CHECK(fabs(w.mean - mean) / mean < 1e-5);
+  CHECK(fabs(welford_variance(&w) - variance) / variance < 1e-3);
+
+  qsort(values, TEST_SAMPLES, sizeof(float), compare_float);
+  CHECK(w.min == values[0]);
+  CHECK(w.max == values[TEST_SAMPLES - 1]);
+
+  // Constant input has none
+  welford_reset(&w);
+  for (uint32_t i = 0; i < 100; i++)
+    welford_add(&w, 42.5f);
+  CHECK(w.mean == 42.5f);
+  CHECK(welford_variance(&w) == 0.0f);
+}
+
+static void test_p2()
+{
+  static float values[TEST_SAMPLES];
+  const float quantiles[] = {0.5f, 0.95f};
+
+  for (uint8_t j = 0; j < sizeof(quantiles) / sizeof(quantiles[0]); j++)
+  {
+    p2_t p2;
+    p2_reset(&p2, quantiles[j]);
+
+    for (uint32_t i = 0; i < TEST_SAMPLES; i++)
+    {
+      values[i] = test_uniform();
+      p2_add(&p2, values[i]);
+    }
+
+    qsort(values, TEST_SAMPLES, sizeof(float), compare_float);
+    float expected = reference_quantile(values, TEST_SAMPLES, quantiles[j]);
+
+    // Within 1% of the range
+    CHECK(fabsf(p2_value(&p2) - expected) < 10);
+    CHECK_EQ(p2.count, TEST_SAMPLES);
+  }
+
+  // Skewed, PM-like: mostly low with rare spikes
+  p2_t p2;
+  p2_reset(&p2, 0.95f);
+
+  for (uint32_t i = 0; i < TEST_SAMPLES; i++)
+  {
+    float u = test_uniform() / 1000;
+    values[i] = 5 + 20 * u * u * u;
+    p2_add(&p2, values[i]);
+  }
+
+  qsort(values, TEST_SAMPLES, sizeof(float), compare_float);
+  float expected = reference_quantile(values, TEST_SAMPLES, 0.95f);
+  CHECK(fabsf(p2_value(&p2) - expected) / expected < 0.02f);
+
+  // Sorted input, the worst case for marker moves
+  p2_reset(&p2, 0.5f);
+  for (uint32_t i = 0; i < 1001; i++)
+    p2_add(&p2, i);
+  CHECK(fabsf(p2_value(&p2) - 500) < 5);
+}
+
+static void test_few_samples()
+{
+  p2_t p2;
+  welford_t w;
+
+  p2_reset(&p2, 0.5f);
+  welford_reset(&w);
+
+  CHECK(p2_value(&p2) == 0.0f);
+  CHECK(welford_variance(&w) == 0.0f);
+
+  // Exact while there are fewer than five
+  p2_add(&p2, 5);
+  welford_add(&w, 5);
+  CHECK(p2_value(&p2) == 5.0f);
+  CHECK(welford_variance(&w) == 0.0f);
+  CHECK(w.min == 5.0f && w.max == 5.0f);
+
+  p2_add(&p2, 1);
+  p2_add(&p2, 3);
+  CHECK(p2_value(&p2) == 3.0f);
+
+  p2_add(&p2, 9);
+  p2_add(&p2, 7);
+  CHECK(p2_value(&p2) == 5.0f);
+}
+
+static void test_window()
+{
+  StreamStats stats;
+  stream_stats_t result;
+
+  stats.setup(1000, 0.5f);
+
+  // Nothing yet, either way
+  CHECK(!stats.get(&result));
+  CHECK(!stats.get(&result, true));
+
+  // One sample
+  uint32_t start = 0xffffff00; // Across a millis() wrap
+  stats.add(start, 7.5f);
+  CHECK(!stats.get(&result));
+  CHECK(stats.get(&result, true));
+  CHECK_EQ(result.count, 1);
+  CHECK(result.mean == 7.5f && result.stddev == 0.0f);
+  CHECK(result.min == 7.5f && result.max == 7.5f && result.quantile == 7.5f);
+  CHECK_EQ(result.start, start);
+  CHECK_EQ(result.end, start);
+
+  // Fills the window, 1..10 every 100 ms
+  for (uint32_t i = 1; i < 10; i++)
+    stats.add(start + i * 100, i);
+
+  CHECK(!stats.get(&result));
+
+  // The first sample at or past its length closes it
+  stats.add(start + 1000, 100);
+  CHECK(stats.get(&result));
+  CHECK_EQ(result.count, 10);
+  CHECK(fabsf(result.mean - (7.5f + 45) / 10) < 1e-4f);
+  CHECK(result.min == 1.0f && result.max == 9.0f);
+  CHECK_EQ(result.start, start);
+  CHECK_EQ(result.end, start + 900);
+
+  // And starts the next one
+  CHECK(stats.get(&result, true));
+  CHECK_EQ(result.count, 1);
+  CHECK(result.mean == 100.0f);
+  CHECK_EQ(result.start, start + 1000);
+
+  // A gap longer than a window closes it on the next sample
+  stats.add(start + 5000, 1);
+  CHECK(stats.get(&result));
+  CHECK_EQ(result.count, 1);
+  CHECK(result.mean == 100.0f);
+
+  // Setup clears both
+  stats.setup(0, 0.5f);
+  CHECK(!stats.get(&result));
+  CHECK(!stats.get(&result, true));
+
+  // No window never closes
+  for (uint32_t i = 0; i < 100; i++)
+    stats.add(i * 3600000, i);
+  CHECK(!stats.get(&result));
+  CHECK(stats.get(&result, true));
+  CHECK_EQ(result.count, 100);
+}
+
+int main()
+{
+  test_welford();
+  test_p2();
+  test_few_samples();
+  test_window();
+
+  return test_result("stream_stats");
+}
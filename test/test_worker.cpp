@@ -0,0 +1,100 @@
+/*
+ * Project Particle Squared
+ * Description: Worker thread and result queue on std::thread
+ * Author: Circuit Dojo LLC
+ * Date: 10/19/2026
+ * License: GNU GPLv3
+ */
+
+#include "test.h"
+#include "worker.h"
+#include "result_queue.h"
+
+#define TEST_READINGS 200
+
+static void test_queue_policies()
+{
+  ResultQueue<uint32_t, 2> queue;
+  uint32_t item;
+
+  // Overwrite is the default
+  queue.push(1);
+  queue.push(2);
+  CHECK(queue.push(3));
+  CHECK(queue.pop(&item));
+  CHECK_EQ(item, 2);
+
+  result_queue_stats_t stats = queue.getStats(true);
+  CHECK_EQ(stats.pushed, 3);
+  CHECK_EQ(stats.overwritten, 1);
+  CHECK_EQ(stats.high_water, 2);
+  CHECK_EQ(stats.depth, 1);
+
+  queue.setPolicy(RESULT_QUEUE_DROP_NEWEST);
+  queue.push(4);
+  CHECK(!queue.push(5));
+  CHECK(queue.pop(&item));
+  CHECK_EQ(item, 3);
+  CHECK(queue.pop(&item));
+  CHECK_EQ(item, 4);
+  CHECK(!queue.pop(&item));
+
+  stats = queue.getStats(false);
+  CHECK_EQ(stats.dropped, 1);
+  CHECK_EQ(stats.depth, 0);
+}
+
+// Producer on the worker, consumer here, like startWorker()/receive()
+static void test_worker_delivery()
+{
+  Worker worker;
+  ResultQueue<uint32_t> queue;
+  std::atomic<uint32_t> produced(0);
+
+  queue.setPolicy(RESULT_QUEUE_DROP_NEWEST);
+
+  CHECK(worker.start("test", [&](void) -> uint32_t
+                     {
+                       if (produced < TEST_READINGS && queue.push(produced))
+                         produced++;
+                       return 0; },
+                     0, WORKER_STACK_SIZE));
+  CHECK(worker.isRunning());
+
+  // Only one thread at a time
+  CHECK(!worker.start("test", nullptr, 0, WORKER_STACK_SIZE));
+
+  uint32_t expected = 0, item;
+  uint64_t deadline = test_now_ns() + 5000000000ULL;
+
+  while (expected < TEST_READINGS && test_now_ns() < deadline)
+  {
+    if (queue.pop(&item))
+    {
+      CHECK_EQ(item, expected);
+      expected++;
+    }
+  }
+
+  worker.stop();
+  CHECK(!worker.isRunning());
+  CHECK_EQ(expected, TEST_READINGS);
+
+  // Nothing lost, back-pressure came from the full queue
+  result_queue_stats_t stats = queue.getStats(false);
+  CHECK_EQ(stats.high_water <= RESULT_QUEUE_DEPTH, true);
+
+  // Can start again after a stop
+  CHECK(worker.start("test", [](void) -> uint32_t
+                     { return WORKER_MAX_WAIT_MS * 10; },
+                     0, WORKER_STACK_SIZE));
+  worker.stop();
+}
+
+int main()
+{
+  test_queue_policies();
+  test_worker_delivery();
+
+  return test_result("worker");
+}